@@ -17,7 +17,7 @@
 // Software defines
 /* ------------------------------------------------------------------------------------------- */
 
-// Timezone (-12 +12)
+// Timezone - Whole hours (-12 to +14) or DS1390Timezone (Hours, Minutes)
 #define TIMEZONE                -3
 
 /* ------------------------------------------------------------------------------------------- */
@@ -126,7 +126,7 @@ void loop()
       break;
   }
 
-  Serial.printf ("%02d/%02d/20%02d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
+  Serial.printf ("%02d/%02d/%04d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
   //Serial.printf ("AM/PM: %d \n", Time.AmPm);
 
   delay (1000);
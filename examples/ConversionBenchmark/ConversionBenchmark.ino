@@ -0,0 +1,262 @@
+/* ------------------------------------------------------------------------------------------- */
+// ConversionBenchmark - This example measures the epoch conversion functions and their
+//                       alternatives over several input distributions
+//
+// Notes:   - Distributions: sequential (7 s steps, like log entries), sweep (whole 2000-2106
+//            range in equal steps), random (whole range) and adversarial (year ends and leap
+//            days)
+//          - Results are in ns and CPU cycles per operation, with the loop overhead removed.
+//            Cycles are counted on ESP boards and derived from F_CPU elsewhere. Instruction
+//            counts are not available on these MCUs
+//          - Build with -DDS1390_ENABLE_YEAR_TABLE=1 to compare with the year start table
+//          - Build with -DDS1390_TIME_FORMAT=DS1390_FORMAT_24H (or _12H) to measure the
+//            conversions without the runtime format checks
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Libraries
+/* ------------------------------------------------------------------------------------------- */
+
+#include "DS1390_SPI.h"       // https://github.com/duarterr/Arduino-DS1390-SPI
+#include "DS1390_Converter.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+
+/* ------------------------------------------------------------------------------------------- */
+// Hardware defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Peripheral pins
+#define PIN_RTC_CS               10
+
+/* ------------------------------------------------------------------------------------------- */
+// Software defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Operations per measurement
+#define ITERATIONS               2000
+
+// Input range - Jan 1, 2000 to the last day a 32-bit epoch reaches
+#define RANGE_START              946684800UL
+#define RANGE_SPAN               (0xFFFFFFFFUL - 86400UL - RANGE_START)
+
+// Adversarial inputs
+#define ADVERSARIAL_COUNT        64
+
+// Cycle counter
+#if defined(ESP32) || defined(ESP8266)
+#define CYCLES()                 ESP.getCycleCount()
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// RTC constructor
+DS1390 Clock (PIN_RTC_CS);
+
+// Cached converter
+DS1390Converter Converter (Clock);
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Date and time struct - From DS1390 library
+DS1390DateTime Time;
+
+// Results are stored here so the calls are not optimized away
+volatile uint32_t Sink;
+
+// Random input state (xorshift32)
+uint32_t Seed = 1;
+
+// Adversarial inputs - Filled in setup
+uint32_t Adversarial[ADVERSARIAL_COUNT];
+
+/* ------------------------------------------------------------------------------------------- */
+// Input distributions
+/* ------------------------------------------------------------------------------------------- */
+
+typedef uint32_t (*Source)(uint16_t Index);
+
+uint32_t sequentialInput (uint16_t Index)
+{
+  return RANGE_START + 400000000UL + (uint32_t)Index * 7;
+}
+
+uint32_t sweepInput (uint16_t Index)
+{
+  return RANGE_START + (RANGE_SPAN / ITERATIONS) * Index;
+}
+
+uint32_t randomInput (uint16_t Index)
+{
+  Seed ^= Seed << 13;
+  Seed ^= Seed >> 17;
+  Seed ^= Seed << 5;
+  return RANGE_START + (Seed % RANGE_SPAN);
+}
+
+uint32_t adversarialInput (uint16_t Index)
+{
+  return Adversarial[Index % ADVERSARIAL_COUNT];
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Operations
+/* ------------------------------------------------------------------------------------------- */
+
+typedef void (*Operation)(uint32_t Epoch);
+
+void opBaseline (uint32_t Epoch)
+{
+  Sink = Epoch;
+}
+
+void opEpochToDateTime (uint32_t Epoch)
+{
+  Clock.epochToDateTime (Epoch, Time, 0);
+}
+
+void opConverter (uint32_t Epoch)
+{
+  Converter.epochToDateTime (Epoch, Time, 0);
+}
+
+void opRoundTrip (uint32_t Epoch)
+{
+  Clock.epochToDateTime (Epoch, Time, 0);
+  Sink = Clock.dateTimeToEpoch (Time, 0);
+}
+
+void opAddSeconds (uint32_t Epoch)
+{
+  Clock.addSeconds (Time, 7);
+}
+
+void opEpochStep (uint32_t Epoch)
+{
+  Clock.epochToDateTime (Clock.dateTimeToEpoch (Time, 0) + 7, Time, 0);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Auxiliary functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Loop overhead - Measured once per distribution
+uint32_t BaselineNs = 0;
+uint32_t BaselineCycles = 0;
+
+// Runs an operation ITERATIONS times and prints ns and cycles per operation
+void measure (const char *Name, const char *Distribution, Operation Op, Source Input, bool Baseline = false)
+{
+  // Same inputs for every operation
+  Seed = 1;
+  Converter.reset ();
+  Clock.epochToDateTime (Input (0), Time, 0);
+
+  const uint32_t StartMicros = micros ();
+#ifdef CYCLES
+  const uint32_t StartCycles = CYCLES ();
+#endif
+
+  for (uint16_t Counter = 0; Counter < ITERATIONS; Counter++)
+    Op (Input (Counter));
+
+#ifdef CYCLES
+  uint32_t Cycles = (CYCLES () - StartCycles) / ITERATIONS;
+#endif
+  uint32_t Ns = ((uint64_t)(micros () - StartMicros) * 1000UL) / ITERATIONS;
+#ifndef CYCLES
+  uint32_t Cycles = ((uint64_t)Ns * (F_CPU / 1000000UL)) / 1000UL;
+#endif
+
+  if (Baseline)
+  {
+    BaselineNs = Ns;
+    BaselineCycles = Cycles;
+    return;
+  }
+
+  Ns = (Ns > BaselineNs) ? (Ns - BaselineNs) : 0;
+  Cycles = (Cycles > BaselineCycles) ? (Cycles - BaselineCycles) : 0;
+
+  Serial.print (Name);
+  Serial.print (" - ");
+  Serial.print (Distribution);
+  Serial.print (": ");
+  Serial.print (Ns);
+  Serial.print (" ns/op, ");
+  Serial.print (Cycles);
+  Serial.println (" cycles/op");
+}
+
+// Runs all operations over one distribution
+void measureAll (const char *Distribution, Source Input)
+{
+  measure ("", Distribution, opBaseline, Input, true);
+  measure ("epochToDateTime", Distribution, opEpochToDateTime, Input);
+  measure ("DS1390Converter", Distribution, opConverter, Input);
+  measure ("epochToDateTime + dateTimeToEpoch", Distribution, opRoundTrip, Input);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Initialization function
+/* ------------------------------------------------------------------------------------------- */
+
+void setup()
+{
+  Serial.begin(74480);
+  while (!Serial);
+
+  Serial.println();
+  Serial.print (DS1390_CODE_NAME);
+  Serial.print (" library v");
+  Serial.println (DS1390_CODE_VERSION);
+  Serial.print ("Year table: ");
+  Serial.println (DS1390_ENABLE_YEAR_TABLE ? "enabled" : "disabled");
+
+  /* ----------------------------------------------------------------------------------------- */
+
+  // Initialize hardware - The time format is read once here
+  Clock.begin();
+  Clock.getTimeFormat ();
+
+  // Adversarial inputs - First and last second of years and the end of February
+  for (uint8_t Counter = 0; Counter < ADVERSARIAL_COUNT; Counter += 4)
+  {
+    DS1390DateTime Edge;
+    Edge.Year = (Counter == (ADVERSARIAL_COUNT - 4)) ? 2100 : (2000 + Counter); // 2100 is not leap
+    Edge.Month = 1;
+    Edge.Day = 1;
+
+    Adversarial[Counter] = Clock.dateTimeToEpoch (Edge, 0);
+    Adversarial[Counter + 1] = Adversarial[Counter] - 1;
+    Adversarial[Counter + 2] = Adversarial[Counter] + 59 * 86400UL - 1;   // Feb 28 23:59:59
+    Adversarial[Counter + 3] = Adversarial[Counter] + 59 * 86400UL;       // Feb 29 or Mar 1
+  }
+
+  // Conversions
+  measureAll ("sequential", sequentialInput);
+  measureAll ("sweep", sweepInput);
+  measureAll ("random", randomInput);
+  measureAll ("adversarial", adversarialInput);
+
+  // Small step - Field carrying against an epoch round-trip
+  measure ("", "sequential", opBaseline, sequentialInput, true);
+  measure ("addSeconds", "sequential", opAddSeconds, sequentialInput);
+  measure ("Epoch round-trip step", "sequential", opEpochStep, sequentialInput);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Loop function
+/* ------------------------------------------------------------------------------------------- */
+
+void loop()
+{
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -12,6 +12,7 @@
 /* ------------------------------------------------------------------------------------------- */
 
 #include "DS1390_SPI.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+#include "DS1390_Drift.h"
 
 #include <NTPClient.h>
 #include <ESP8266WiFi.h>
@@ -32,7 +33,7 @@
 const char *ssid     = "ssid";
 const char *password = "psw";
 
-// Timezone (-12 +12)
+// Timezone - Whole hours (-12 to +14) or DS1390Timezone (Hours, Minutes)
 #define TIMEZONE                 -3
 
 /* ------------------------------------------------------------------------------------------- */
@@ -45,6 +46,9 @@ DS1390 Clock (PIN_RTC_CS);
 // Date and time struct - From DS1390 library
 DS1390DateTime Time;
 
+// Drift estimator - From DS1390 library
+DS1390Drift Drift;
+
 // UDP
 WiFiUDP UDP;
 
@@ -148,7 +152,7 @@ void loop()
       break;
   }
 
-  Serial.printf ("%02d/%02d/20%02d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
+  Serial.printf ("%02d/%02d/%04d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
   //Serial.printf ("AM/PM: %d \n", Time.AmPm);
 
   Serial.printf ("Epoch: %d \n", Epoch);
@@ -186,10 +190,19 @@ void loop()
       break;
   }
 
-  Serial.printf ("%02d/%02d/20%02d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
+  Serial.printf ("%02d/%02d/%04d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
   //Serial.printf ("AM/PM: %d \n", Time.AmPm);
 
-  Serial.printf ("Epoch: %d \n\n", NTP.getEpochTime());
+  Serial.printf ("Epoch: %d \n", NTP.getEpochTime());
+
+  // Feed drift estimator - NTPClient gives whole seconds only, so the estimate gets better
+  // as the samples span more time
+  Drift.addSample (Clock, NTP.getEpochTime(), 0, TIMEZONE);
+  Serial.printf ("Drift: %.1f ppm (%u samples) \n\n", Drift.getPpm(), Drift.getSamples());
+
+  // Store estimate after 12 hours of samples. It is applied in getDateTimeEpoch from then on
+  //if (Drift.getSamples() >= 43200)
+  //  Drift.apply (Clock);
 
   delay (1000);
 }
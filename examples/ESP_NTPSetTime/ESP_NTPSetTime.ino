@@ -12,6 +12,7 @@
 /* ------------------------------------------------------------------------------------------- */
 
 #include "DS1390_SPI.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+#include "DS1390_SampleFilter.h"
 
 #include <NTPClient.h>
 #include <ESP8266WiFi.h>
@@ -32,9 +33,17 @@
 const char *ssid     = "ssid";
 const char *password = "psw";
 
-// Timezone (-12 +12)
+// Timezone - Whole hours (-12 to +14) or DS1390Timezone (Hours, Minutes)
 #define TIMEZONE                 -3
 
+// NTP samples - Server, local UDP port and reply timeout (ms)
+#define NTP_SERVER               "0.br.pool.ntp.org"
+#define NTP_LOCAL_PORT           2390
+#define NTP_TIMEOUT_MS           1000
+
+// Seconds from Jan 1, 1900 (NTP era) to Jan 1, 1970 (Epoch)
+#define NTP_UNIX_OFFSET          2208988800UL
+
 /* ------------------------------------------------------------------------------------------- */
 // Constructor
 /* ------------------------------------------------------------------------------------------- */
@@ -45,16 +54,72 @@ DS1390 Clock (PIN_RTC_CS);
 // Date and time struct - From DS1390 library
 DS1390DateTime Time;
 
-// UDP
+// NTP sample filter - From DS1390 library
+DS1390SampleFilter Filter;
+
+// UDP - NTP client and NTP samples
 WiFiUDP UDP;
+WiFiUDP SampleUDP;
 
 // NTP client - Result is given by server closest to you, so it's usually in your timezone
-NTPClient NTP(UDP, "0.br.pool.ntp.org"); // Brazilian server
+NTPClient NTP(UDP, NTP_SERVER); // Brazilian server
 
 /* ------------------------------------------------------------------------------------------- */
 // Variables
 /* ------------------------------------------------------------------------------------------- */
 
+/* ------------------------------------------------------------------------------------------- */
+// NTP sample source
+/* ------------------------------------------------------------------------------------------- */
+
+// Requests the NTP time and measures the round-trip delay. NTPClient only gives whole seconds,
+// so the request is sent here and the milliseconds are taken from the fraction of the server
+// transmit timestamp
+bool ntpSample (DS1390Sample &Sample)
+{
+  // Request - LI = 0, version 3, client mode
+  uint8_t Packet[48] = { 0x1B };
+
+  // Drop late replies from previous requests - Each call discards the previous packet
+  while (SampleUDP.parsePacket() > 0);
+
+  uint32_t Start = micros();
+
+  SampleUDP.beginPacket (NTP_SERVER, 123);
+  SampleUDP.write (Packet, sizeof(Packet));
+  if (!SampleUDP.endPacket())
+    return false;
+
+  // Wait for the reply
+  while (SampleUDP.parsePacket() < (int)sizeof(Packet))
+  {
+    if (micros() - Start > NTP_TIMEOUT_MS * 1000UL)
+      return false;
+
+    yield();
+  }
+
+  Sample.CaptureMicros = micros();
+  Sample.DelayMicros = Sample.CaptureMicros - Start;
+
+  SampleUDP.read (Packet, sizeof(Packet));
+
+  // Transmit timestamp - Seconds since 1900 and 32-bit fraction, big endian
+  const uint32_t Seconds = ((uint32_t)Packet[40] << 24) | ((uint32_t)Packet[41] << 16)
+                           | ((uint32_t)Packet[42] << 8) | Packet[43];
+  const uint32_t Fraction = ((uint32_t)Packet[44] << 24) | ((uint32_t)Packet[45] << 16)
+                            | ((uint32_t)Packet[46] << 8) | Packet[47];
+
+  // Unsynchronized server
+  if (Seconds == 0)
+    return false;
+
+  Sample.Epoch = Seconds - NTP_UNIX_OFFSET;
+  Sample.Milliseconds = ((uint64_t)Fraction * 1000) >> 32;
+
+  return true;
+}
+
 /* ------------------------------------------------------------------------------------------- */
 // Initialization function
 /* ------------------------------------------------------------------------------------------- */
@@ -103,8 +168,9 @@ void setup()
   Serial.println ("Done.");
   Serial.println();
 
-  // Start NTP client
+  // Start NTP client and sample socket
   NTP.begin();
+  SampleUDP.begin (NTP_LOCAL_PORT);
 
 
 
@@ -146,7 +212,7 @@ void setup()
       break;
   }
 
-  Serial.printf ("%02d/%02d/20%02d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
+  Serial.printf ("%02d/%02d/%04d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
   //Serial.printf ("AM/PM: %d \n", Time.AmPm);
 
   Serial.printf ("Epoch: %d \n", Epoch);
@@ -189,7 +255,7 @@ void setup()
       break;
   }
 
-  Serial.printf ("%02d/%02d/20%02d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
+  Serial.printf ("%02d/%02d/%04d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
   //Serial.printf ("AM/PM: %d \n", Time.AmPm);
 
   Serial.printf ("Epoch: %d \n", NTP.getEpochTime());
@@ -199,8 +265,15 @@ void setup()
 
 
 
-  // Update DS1390 time using Epoch timestamp
-  Clock.setDateTimeEpoch (NTP.getEpochTime(), TIMEZONE);
+  // Update DS1390 time using the NTP sample with the smallest round-trip delay
+  Filter.collect (ntpSample, DS1390_FILTER_MAX_SAMPLES, 500);
+  if (!Filter.apply (Clock, TIMEZONE))
+    Serial.println ("No NTP samples or late RTC write");
+
+  // OR
+
+//  // Update DS1390 time using Epoch timestamp
+//  Clock.setDateTimeEpoch (NTP.getEpochTime(), TIMEZONE);
 
   // OR
 
@@ -212,14 +285,10 @@ void setup()
 
 
 
-  // Read DS1390 registers individually
-  Time.Second = Clock.getDateTimeSeconds ();
-  Time.Minute = Clock.getDateTimeMinutes ();
-  Time.Hour = Clock.getDateTimeHours ();
-  Time.Wday = Clock.getDateTimeWday ();
-  Time.Day = Clock.getDateTimeDay ();
-  Time.Month = Clock.getDateTimeMonth ();
-  Time.Year = Clock.getDateTimeYear ();
+  // Read all DS1390 registers at once - Reading them individually may mix values from
+  // before and after a rollover
+  uint8_t Reads = Clock.getDateTimeSnapshot (Time);
+  Serial.printf ("Snapshot bursts: %d \n", Reads);
 
   // Display result
   Serial.println ("New DS1390 value: ");
@@ -249,7 +318,7 @@ void setup()
       break;
   }
 
-  Serial.printf ("%02d/%02d/20%02d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
+  Serial.printf ("%02d/%02d/%04d - %02d:%02d:%02d \n", Time.Day, Time.Month, Time.Year, Time.Hour, Time.Minute, Time.Second);
   //Serial.printf ("AM/PM: %d \n", Time.AmPm);
 
   Epoch = Clock.dateTimeToEpoch (Time, TIMEZONE);
@@ -0,0 +1,220 @@
+/* ------------------------------------------------------------------------------------------- */
+// ESP_PublisherStress - This example stresses DS1390Publisher with reader tasks on both cores
+//
+// Notes:   - ESP32 only. The refresher task runs every REFRESH_MS on any core
+//          - One reader task per entry of Readers, pinned to a core. Readers with a priority
+//            above DS1390_PUBLISHER_PRIORITY preempt the refresher mid-publish on their core
+//          - Each read is checked for consistency: the epoch must match the DateTime (torn copy)
+//            and neither the epoch nor the generation may go back
+//          - Failed reads (no consistent copy in DS1390_PUBLISHER_RETRIES attempts) are counted
+//            but are not errors. Torn or backward reads are
+//          - Results are printed every REPORT_MS
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Libraries
+/* ------------------------------------------------------------------------------------------- */
+
+#include "DS1390_SPI.h"       // https://github.com/duarterr/Arduino-DS1390-SPI
+#include "DS1390_Publisher.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+
+#if !defined(ESP32)
+#error "This example needs FreeRTOS tasks on an ESP32"
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// Hardware defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Peripheral pins
+#define PIN_RTC_CS               10
+
+/* ------------------------------------------------------------------------------------------- */
+// Software defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Refresher period
+#define REFRESH_MS               1
+
+// Reads between two delays of a reader - Lets the idle tasks run
+#define READS_PER_BURST          2000
+
+// Step back allowed for getEpoch - One hundredth plus one millis() tick
+#define BACKSTEP_MS              11
+
+// Timezone of the published epoch - UTC-3
+#define TIMEZONE                 -3
+
+// Report period
+#define REPORT_MS                5000
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// RTC constructor
+DS1390 Clock (PIN_RTC_CS);
+
+// Publisher constructor
+DS1390Publisher Publisher (Clock, TIMEZONE);
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Reader task settings
+struct Reader
+{
+  uint8_t Core;
+  uint8_t Priority;
+};
+
+const Reader Readers[] = {
+  { 0, DS1390_PUBLISHER_PRIORITY - 1 },
+  { 0, DS1390_PUBLISHER_PRIORITY + 1 },
+  { 1, DS1390_PUBLISHER_PRIORITY - 1 },
+  { 1, DS1390_PUBLISHER_PRIORITY + 1 }
+};
+
+#define READERS                  (sizeof(Readers) / sizeof(Readers[0]))
+
+// Software trim applied to the published epoch - Read once in setup()
+int8_t Trim = 0;
+uint32_t TrimAnchor = 0;
+
+// Results - One slot per reader task
+volatile uint32_t Reads[READERS];
+volatile uint32_t Failures[READERS];
+volatile uint32_t Torn[READERS];
+volatile uint32_t Backwards[READERS];
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Reader task body - Parameter is the index in Readers
+void readerTask (void *Parameter)
+{
+  const uint32_t Index = (uint32_t)Parameter;
+  uint32_t LastEpoch = 0;
+  uint32_t LastSeconds = 0;
+  uint16_t LastMilliseconds = 0;
+  uint32_t LastGeneration = 0;
+
+  for (;;)
+  {
+    for (uint16_t Count = 0; Count < READS_PER_BURST; Count++)
+    {
+      DS1390DateTime DateTime;
+      uint32_t Epoch;
+      uint16_t Milliseconds;
+
+      // Generation first - Every copy read after it is at least as new
+      const uint32_t Generation = Publisher.getGeneration ();
+      if (Generation < LastGeneration)
+        Backwards[Index]++;
+      LastGeneration = Generation;
+
+      // Published copy - Epoch must match the DateTime (trimmed like the published epoch)
+      if (!Publisher.read (DateTime, &Epoch))
+        Failures[Index]++;
+
+      else
+      {
+        uint16_t Trimmed = DateTime.Hsecond * 10;
+        if (DS1390::trimEpoch (Clock.dateTimeToEpoch (DateTime, TIMEZONE), Trimmed, Trim, TrimAnchor) != Epoch)
+          Torn[Index]++;
+
+        if (Epoch < LastEpoch)
+          Backwards[Index]++;
+
+        LastEpoch = Epoch;
+      }
+
+      // Extrapolated epoch - Published milliseconds are truncated to hundredths, so it may
+      // step back by up to BACKSTEP_MS at each refresh
+      const uint32_t Seconds = Publisher.getEpoch (&Milliseconds);
+      if (Seconds == 0)
+        Failures[Index]++;
+
+      else
+      {
+        const int32_t Step = (int32_t)(Seconds - LastSeconds) * 1000L + Milliseconds - LastMilliseconds;
+        if ((LastSeconds != 0) && (Step < -BACKSTEP_MS))
+          Backwards[Index]++;
+
+        LastSeconds = Seconds;
+        LastMilliseconds = Milliseconds;
+      }
+
+      Reads[Index] += 2;
+    }
+
+    vTaskDelay (1);
+  }
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Setup function
+/* ------------------------------------------------------------------------------------------- */
+
+void setup()
+{
+  // Initialize serial port
+  Serial.begin(74480);
+  while (!Serial);
+
+  Serial.println();
+  Serial.printf ("%s library v%s \n", DS1390_CODE_NAME, DS1390_CODE_VERSION);
+
+  // Initialize RTC
+  Clock.begin();
+
+  // Start refresher task - First refresh is done before it returns
+  if (!Publisher.begin (REFRESH_MS))
+  {
+    Serial.println ("Refresher task could not be created");
+    while (1);
+  }
+
+  // Trim used by the refresher - Cached by the first refresh
+  Trim = Clock.getTrim ();
+  TrimAnchor = Clock.getTrimAnchor ();
+
+  // Start reader tasks
+  for (uint32_t Index = 0; Index < READERS; Index++)
+    xTaskCreatePinnedToCore (readerTask, "reader", 4096, (void *)Index, Readers[Index].Priority, NULL, Readers[Index].Core);
+
+  Serial.printf ("%u readers, refresh every %u ms, %u retries \n", (unsigned)READERS, REFRESH_MS, DS1390_PUBLISHER_RETRIES);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Loop function
+/* ------------------------------------------------------------------------------------------- */
+
+void loop()
+{
+  delay (REPORT_MS);
+
+  uint32_t Errors = 0;
+
+  Serial.printf ("Generation %u \n", Publisher.getGeneration ());
+
+  // Per reader results
+  for (uint8_t Index = 0; Index < READERS; Index++)
+  {
+    Serial.printf ("Core %u priority %u: %u reads, %u failed, %u torn, %u backwards \n",
+                   Readers[Index].Core, Readers[Index].Priority, Reads[Index], Failures[Index],
+                   Torn[Index], Backwards[Index]);
+
+    Errors += Torn[Index] + Backwards[Index];
+  }
+
+  Serial.println (Errors == 0 ? "PASS" : "FAIL");
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
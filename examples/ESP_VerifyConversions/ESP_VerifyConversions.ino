@@ -0,0 +1,356 @@
+/* ------------------------------------------------------------------------------------------- */
+// ESP_VerifyConversions - This example checks the calendar code of the library against the
+//                         C library (gmtime_r and mktime in UTC)
+//
+// Notes:   - Checked paths: epochToDateTime, dateTimeToEpoch, DS1390Converter, addSeconds,
+//            weekDayFromDate, dec2bcd and bcd2dec. Build with -DDS1390_ENABLE_YEAR_TABLE=1 to
+//            check the year start table too
+//          - Day sweep: one time of day for every day from 2000 to the end of the 32-bit
+//            epoch (2106), or 2038 if time_t has 32 bits
+//          - Second sweep: every second of the days in SecondDays (leap days, century, year
+//            ends and the 32-bit limits). Set SECOND_SWEEP_ALL to 1 to check every second of
+//            the whole range instead (takes hours)
+//          - On ESP32, each sweep is split between both cores
+//          - The first mismatch found is printed. The summary lists the exact epoch ranges
+//            checked by each sweep - Any second not listed there was not checked
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Libraries
+/* ------------------------------------------------------------------------------------------- */
+
+#include "DS1390_SPI.h"       // https://github.com/duarterr/Arduino-DS1390-SPI
+#include "DS1390_Converter.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+
+#include <time.h>
+
+/* ------------------------------------------------------------------------------------------- */
+// Hardware defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Peripheral pins
+#define PIN_RTC_CS               10
+
+/* ------------------------------------------------------------------------------------------- */
+// Software defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Every second of the range instead of the selected days only
+#define SECOND_SWEEP_ALL         0
+
+// First day checked - Jan 1, 2000
+#define FIRST_DAY                10957UL
+
+// Last epoch checked - Limited by the 32-bit epoch or by a 32-bit time_t
+#define LAST_EPOCH               ((sizeof(time_t) > 4) ? 0xFFFFFFFFUL : 0x7FFFFFFFUL)
+
+// Last day checked
+#define LAST_DAY                 (LAST_EPOCH / 86400UL)
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// RTC constructor - Conversions only, the time format is read once
+DS1390 Clock (PIN_RTC_CS);
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Days checked every second - Days since Jan 1, 1970
+const uint32_t SecondDays[] = {
+  10956,    // Dec 31, 1999
+  10957,    // Jan 1, 2000
+  11016,    // Feb 29, 2000 (leap century)
+  11017,    // Mar 1, 2000
+  24855,    // Jan 19, 2038 (31-bit limit)
+  47540,    // Feb 28, 2100 (not leap)
+  47541,    // Mar 1, 2100
+  49710     // Feb 7, 2106 (32-bit limit)
+};
+
+// Results - Updated by the sweep tasks
+volatile uint32_t DayChecks = 0;
+volatile uint32_t SecondChecks = 0;
+volatile uint32_t Mismatches = 0;
+
+// First mismatch already printed
+volatile bool Reported = false;
+
+#if defined(ESP32)
+// Results lock
+portMUX_TYPE ReportMux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// Auxiliary functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Prints an epoch range with its reference dates
+void printRange (const char *Name, uint32_t First, uint32_t Last, uint32_t Checked)
+{
+  const time_t FirstTime = First;
+  const time_t LastTime = Last;
+  struct tm Start;
+  struct tm End;
+  gmtime_r (&FirstTime, &Start);
+  gmtime_r (&LastTime, &End);
+
+  Serial.printf ("  %s: epochs %u to %u (%04d-%02d-%02d %02d:%02d:%02d to %04d-%02d-%02d %02d:%02d:%02d), "
+                 "%u checked \n", Name, First, Last, Start.tm_year + 1900, Start.tm_mon + 1,
+                 Start.tm_mday, Start.tm_hour, Start.tm_min, Start.tm_sec, End.tm_year + 1900,
+                 End.tm_mon + 1, End.tm_mday, End.tm_hour, End.tm_min, End.tm_sec, Checked);
+}
+
+// Prints the first mismatch only
+void report (const char *Path, uint32_t Epoch, const DS1390DateTime &DateTime, const struct tm &Reference)
+{
+  bool First = false;
+
+#if defined(ESP32)
+  portENTER_CRITICAL (&ReportMux);
+#endif
+  Mismatches++;
+  if (!Reported)
+  {
+    Reported = true;
+    First = true;
+  }
+#if defined(ESP32)
+  portEXIT_CRITICAL (&ReportMux);
+#endif
+
+  if (!First)
+    return;
+
+  Serial.printf ("First mismatch (%s) at epoch %u: got %04d-%02d-%02d %02d:%02d:%02d wday %d, "
+                 "expected %04d-%02d-%02d %02d:%02d:%02d wday %d \n", Path, Epoch,
+                 DateTime.Year, DateTime.Month, DateTime.Day, DateTime.Hour, DateTime.Minute,
+                 DateTime.Second, DateTime.Wday, Reference.tm_year + 1900, Reference.tm_mon + 1,
+                 Reference.tm_mday, Reference.tm_hour, Reference.tm_min, Reference.tm_sec,
+                 Reference.tm_wday + 1);
+}
+
+// Compares a DS1390DateTime structure with a tm structure - Hours in 24h format
+bool sameTime (const DS1390DateTime &DateTime, const struct tm &Reference)
+{
+  uint8_t Hour = DateTime.Hour;
+
+  if (Clock.getTimeFormat () == DS1390_FORMAT_12H)
+    Hour = (Hour % 12) + ((DateTime.AmPm == DS1390_PM) ? 12 : 0);
+
+  return (DateTime.Year == Reference.tm_year + 1900) && (DateTime.Month == Reference.tm_mon + 1)
+         && (DateTime.Day == Reference.tm_mday) && (Hour == Reference.tm_hour)
+         && (DateTime.Minute == Reference.tm_min) && (DateTime.Second == Reference.tm_sec)
+         && (DateTime.Wday == Reference.tm_wday + 1);
+}
+
+// Checks one epoch on every path. Running keeps the previous result, advanced with addSeconds
+void check (uint32_t Epoch, DS1390Converter &Converter, DS1390DateTime &Running, uint32_t &RunningEpoch)
+{
+  // Reference
+  const time_t Time = Epoch;
+  struct tm Reference;
+  gmtime_r (&Time, &Reference);
+
+  // Epoch to date and time
+  DS1390DateTime DateTime;
+  Clock.epochToDateTime (Epoch, DateTime, 0);
+
+  if (!sameTime (DateTime, Reference))
+    report ("epochToDateTime", Epoch, DateTime, Reference);
+
+  // Date and time to epoch - Also checked against mktime
+  if ((Clock.dateTimeToEpoch (DateTime, 0) != Epoch) || ((uint32_t)mktime (&Reference) != Epoch))
+    report ("dateTimeToEpoch", Epoch, DateTime, Reference);
+
+  // Week day from date
+  DS1390DateTime NoWday = DateTime;
+  NoWday.Wday = 0;
+  if (DS1390::weekDayFromDate (NoWday) != Reference.tm_wday + 1)
+    report ("weekDayFromDate", Epoch, DateTime, Reference);
+
+  // Cached converter
+  DS1390DateTime Cached;
+  Converter.epochToDateTime (Epoch, Cached, 0);
+  if (!sameTime (Cached, Reference))
+    report ("DS1390Converter", Epoch, Cached, Reference);
+
+  // Field carrying from the previous epoch
+  Clock.addSeconds (Running, (int32_t)(Epoch - RunningEpoch));
+  RunningEpoch = Epoch;
+  if (!sameTime (Running, Reference))
+    report ("addSeconds", Epoch, Running, Reference);
+}
+
+// Sweeps part of the range. Slice/Slices split it between tasks
+void sweep (uint8_t Slice, uint8_t Slices)
+{
+  DS1390Converter Converter (Clock);
+  DS1390DateTime Running;
+  uint32_t RunningEpoch = FIRST_DAY * 86400UL;
+  uint32_t Days = 0;
+  uint32_t Seconds = 0;
+  Clock.epochToDateTime (RunningEpoch, Running, 0);
+
+  // One time of day for every day - Spread over the day
+  for (uint32_t Day = FIRST_DAY + Slice; Day <= LAST_DAY; Day += Slices, Days++)
+  {
+    uint32_t Epoch = Day * 86400UL + (Day * 7919UL) % 86400UL;
+    if (Epoch > LAST_EPOCH)
+      Epoch = LAST_EPOCH;
+
+    check (Epoch, Converter, Running, RunningEpoch);
+  }
+
+#if SECOND_SWEEP_ALL
+  // Every second of the range
+  for (uint32_t Day = FIRST_DAY + Slice; Day <= LAST_DAY; Day += Slices)
+#else
+  // Every second of the selected days
+  for (uint8_t Index = Slice; Index < (sizeof(SecondDays) / sizeof(SecondDays[0])); Index += Slices)
+#endif
+  {
+#if !SECOND_SWEEP_ALL
+    const uint32_t Day = SecondDays[Index];
+    if ((Day < FIRST_DAY - 1) || (Day > LAST_DAY))
+      continue;
+#endif
+
+    // Restart the running date at midnight
+    RunningEpoch = Day * 86400UL;
+    Clock.epochToDateTime (RunningEpoch, Running, 0);
+
+    for (uint32_t Second = 0; Second < 86400UL; Second++, Seconds++)
+    {
+      // Last day may end early
+      if ((Day * 86400UL + Second) > LAST_EPOCH)
+        break;
+
+      check (Day * 86400UL + Second, Converter, Running, RunningEpoch);
+    }
+
+    yield ();
+  }
+
+#if defined(ESP32)
+  portENTER_CRITICAL (&ReportMux);
+#endif
+  DayChecks += Days;
+  SecondChecks += Seconds;
+#if defined(ESP32)
+  portEXIT_CRITICAL (&ReportMux);
+#endif
+}
+
+#if defined(ESP32)
+// Second core task
+volatile bool TaskDone = false;
+
+void sweepTask (void *Parameter)
+{
+  sweep (1, 2);
+  TaskDone = true;
+  vTaskDelete (NULL);
+}
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// Initialization function
+/* ------------------------------------------------------------------------------------------- */
+
+void setup()
+{
+  Serial.begin(74480);
+  while (!Serial);
+
+  Serial.println();
+  Serial.printf ("%s library v%s \n", DS1390_CODE_NAME, DS1390_CODE_VERSION);
+
+  /* ----------------------------------------------------------------------------------------- */
+
+  // Initialize hardware - The time format is cached before the tasks start
+  Clock.begin();
+  Clock.getTimeFormat ();
+
+  // Reference in UTC
+  setenv ("TZ", "UTC0", 1);
+  tzset ();
+
+  // BCD - Every valid value
+  for (uint8_t Value = 0; Value < 100; Value++)
+  {
+    if ((DS1390::dec2bcd (Value) != (((Value / 10) << 4) | (Value % 10)))
+        || (DS1390::bcd2dec (DS1390::dec2bcd (Value)) != Value))
+    {
+      Serial.printf ("First mismatch (BCD) at value %d \n", Value);
+      Mismatches++;
+      break;
+    }
+  }
+
+  Serial.printf ("Year table: %s \n", DS1390_ENABLE_YEAR_TABLE ? "enabled" : "disabled");
+  Serial.printf ("Checking epochs %u to %u... \n", FIRST_DAY * 86400UL, LAST_EPOCH);
+
+  const uint32_t Start = millis ();
+
+#if defined(ESP32)
+  // Half of the work on each core
+  xTaskCreatePinnedToCore (sweepTask, "sweep", 4096, NULL, 1, NULL, 0);
+  sweep (0, 2);
+
+  while (!TaskDone)
+    delay (10);
+#else
+  sweep (0, 1);
+#endif
+
+  const uint32_t Elapsed = millis () - Start;
+
+  // Exact coverage
+  Serial.println ("Checked ranges:");
+  Serial.printf ("  Day sweep: 1 second of each day in the range (day * 86400 + (day * 7919) %% 86400) \n");
+  printRange ("Range", FIRST_DAY * 86400UL, LAST_EPOCH, DayChecks);
+
+#if SECOND_SWEEP_ALL
+  Serial.printf ("  Second sweep: every second \n");
+  printRange ("All", FIRST_DAY * 86400UL, LAST_EPOCH, SecondChecks);
+#else
+  Serial.printf ("  Second sweep: every second of these %u days only, %u checked \n",
+                 (unsigned)(sizeof(SecondDays) / sizeof(SecondDays[0])), SecondChecks);
+
+  for (uint8_t Index = 0; Index < (sizeof(SecondDays) / sizeof(SecondDays[0])); Index++)
+  {
+    const uint32_t Day = SecondDays[Index];
+
+    // Outside the range - Not checked
+    if ((Day < FIRST_DAY - 1) || (Day > LAST_DAY))
+    {
+      Serial.printf ("  Day %u: skipped (outside the range) \n", Day);
+      continue;
+    }
+
+    const uint32_t Last = (Day * 86400UL + 86399UL > LAST_EPOCH) ? LAST_EPOCH : Day * 86400UL + 86399UL;
+    printRange ("Day", Day * 86400UL, Last, Last - Day * 86400UL + 1);
+  }
+
+  Serial.println ("  Other seconds were not checked - Set SECOND_SWEEP_ALL to 1 for all of them");
+#endif
+
+  Serial.printf ("%u checks, %u mismatches, %u ms \n", DayChecks + SecondChecks, Mismatches, Elapsed);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Loop function
+/* ------------------------------------------------------------------------------------------- */
+
+void loop()
+{
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -0,0 +1,202 @@
+/* ------------------------------------------------------------------------------------------- */
+// SlewConvergence - This example checks DS1390Slew against a synthetic reference clock: the
+//                   served time must converge to it without exceeding the slew rate
+//
+// Notes:   - The reference is the served time at the start plus OFFSET_MS, advanced with
+//            millis(). It assumes the MCU and RTC oscillators agree within a few hundred ppm
+//          - getEpoch is polled every POLL_MS, like an application reading the time often.
+//            Every CHECK_MS the sketch checks that the pending correction moved by the slew
+//            rate, that the served time is off the reference by the pending correction and
+//            that the error did not change faster than the slew rate
+//          - A positive and a negative offset are tested. The RTC time is overwritten
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Libraries
+/* ------------------------------------------------------------------------------------------- */
+
+#include "DS1390_SPI.h"  // https://github.com/duarterr/Arduino-DS1390-SPI
+#include "DS1390_Slew.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+
+/* ------------------------------------------------------------------------------------------- */
+// Hardware defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Peripheral pins
+#define PIN_RTC_CS               10
+
+/* ------------------------------------------------------------------------------------------- */
+// Software defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Slew rate (ppm) - Default rate: with POLL_MS = 1, each update serves less than 1 us
+#define RATE_PPM                 DS1390_SLEW_RATE_PPM
+
+// Injected offset (ms) - Takes OFFSET_MS * 1000000 / RATE_PPM ms to slew
+#define OFFSET_MS                100
+
+// getEpoch polling and check periods (ms)
+#define POLL_MS                  1
+#define CHECK_MS                 10000
+
+// Tolerance of served time checks (ms) - RTC resolution is one hundredth
+#define TOLERANCE_MS             20
+
+// Time set before each test - Jan 1, 2026 00:00:00
+#define START_EPOCH              1767225600UL
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// RTC constructor
+DS1390 Clock (PIN_RTC_CS);
+
+// Slewed time
+DS1390Slew Slew (Clock, RATE_PPM);
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Failed checks
+uint16_t Failures = 0;
+
+/* ------------------------------------------------------------------------------------------- */
+// Auxiliary functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Served time in ms since START_EPOCH
+int32_t served ()
+{
+  uint16_t Milliseconds = 0;
+  const uint32_t Epoch = Slew.getEpoch (0, &Milliseconds);
+
+  return (int32_t)(Epoch - START_EPOCH) * 1000 + Milliseconds;
+}
+
+// Counts and prints a failed check
+void check (bool Passed, const char *Name, int32_t Value)
+{
+  if (Passed)
+    return;
+
+  Failures++;
+  Serial.print ("  FAIL: ");
+  Serial.print (Name);
+  Serial.print (" (");
+  Serial.print (Value);
+  Serial.println (" ms)");
+}
+
+// Slews by Offset and checks every CHECK_MS until well past the expected convergence
+void runTest (int32_t Offset)
+{
+  Serial.print ("Offset ");
+  Serial.print (Offset);
+  Serial.println (" ms");
+
+  // Known starting point
+  Clock.setDateTimeEpoch (START_EPOCH, 0);
+
+  // Reference - Served time plus offset, advanced with millis()
+  const uint32_t StartMillis = millis ();
+  const int32_t Reference = served () + Offset;
+  check (Slew.adjust (Offset), "adjust", Offset);
+
+  // Expected convergence time plus margin
+  const uint32_t Duration = (uint32_t)((Offset < 0) ? -Offset : Offset) * 1000000UL / RATE_PPM * 6 / 5 + 2 * CHECK_MS;
+
+  // Values at the last check
+  uint32_t LastCheck = StartMillis;
+  int32_t LastPending = Slew.getPending ();
+  int32_t LastError = Offset;
+
+  while (millis () - StartMillis < Duration)
+  {
+    // Frequent reads - Each one serves a tiny part of the correction
+    delay (POLL_MS);
+    const int32_t Served = served ();
+    const uint32_t Now = millis ();
+
+    if (Now - LastCheck < CHECK_MS)
+      continue;
+
+    // Current state
+    const int32_t Pending = Slew.getPending ();
+    const int32_t Error = Reference + (int32_t)(Now - StartMillis) - Served;
+
+    // Largest move allowed by the slew rate since the last check
+    const int32_t Step = (int32_t)((Now - LastCheck) * RATE_PPM / 1000000UL);
+    const int32_t Expected = (LastPending > 0) ? min (LastPending, Step) : -min (-LastPending, Step);
+
+    Serial.print ("  t = ");
+    Serial.print ((Now - StartMillis) / 1000);
+    Serial.print (" s, error = ");
+    Serial.print (Error);
+    Serial.print (" ms, pending = ");
+    Serial.print (Pending);
+    Serial.println (" ms");
+
+    // Pending correction moved by the slew rate - 2 ms for millis() and ms truncation
+    const int32_t Moved = LastPending - Pending;
+    check (abs (Moved - Expected) <= 2, "pending step", Moved - Expected);
+
+    // Served time is off the reference by the pending correction
+    check (abs (Error - Pending) <= TOLERANCE_MS, "served error", Error - Pending);
+
+    // Error did not change faster than the slew rate
+    check (abs (LastError - Error) <= Step + 2 * TOLERANCE_MS, "rate bound", LastError - Error);
+
+    LastCheck = Now;
+    LastPending = Pending;
+    LastError = Error;
+  }
+
+  // Converged
+  check (Slew.getPending () == 0, "converged", Slew.getPending ());
+  check (abs (LastError) <= TOLERANCE_MS, "final error", LastError);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Initialization function
+/* ------------------------------------------------------------------------------------------- */
+
+void setup()
+{
+  Serial.begin(74480);
+  while (!Serial);
+
+  Serial.println();
+  Serial.print (DS1390_CODE_NAME);
+  Serial.print (" library v");
+  Serial.println (DS1390_CODE_VERSION);
+
+  /* ----------------------------------------------------------------------------------------- */
+
+  // Initialize hardware
+  Clock.begin ();
+
+  // Offsets above the limit must be rejected
+  check (!Slew.adjust (DS1390_SLEW_MAX_OFFSET_MS + 1), "large offset rejected", DS1390_SLEW_MAX_OFFSET_MS + 1);
+
+  runTest (OFFSET_MS);
+  runTest (-OFFSET_MS);
+
+  Serial.print ("Failed checks: ");
+  Serial.println (Failures);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Loop function
+/* ------------------------------------------------------------------------------------------- */
+
+void loop()
+{
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
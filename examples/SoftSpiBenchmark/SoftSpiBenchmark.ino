@@ -0,0 +1,151 @@
+/* ------------------------------------------------------------------------------------------- */
+// SoftSpiBenchmark - This example compares the time taken by a full date and time read
+//                    (9 byte transaction) using the hardware SPI bus, the DS1390SoftSpi bus
+//                    and a plain digitalWrite based bit-banged transfer
+//
+// Notes:   - The software buses use the hardware SPI pins, so the same wiring works for all
+//            three tests. The hardware SPI bus is released before the software tests
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Libraries
+/* ------------------------------------------------------------------------------------------- */
+
+#include "DS1390_SPI.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+
+/* ------------------------------------------------------------------------------------------- */
+// Hardware defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Peripheral pins
+#define PIN_RTC_CS               10
+#define PIN_RTC_SCK              SCK
+#define PIN_RTC_MOSI             MOSI
+#define PIN_RTC_MISO             MISO
+
+/* ------------------------------------------------------------------------------------------- */
+// Software defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Reads per test
+#define ITERATIONS               1000
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// Software SPI bus
+DS1390SoftSpi Bus (PIN_RTC_SCK, PIN_RTC_MOSI, PIN_RTC_MISO);
+
+// RTC constructors - Hardware and software SPI bus
+DS1390 HardClock (PIN_RTC_CS);
+DS1390 SoftClock (PIN_RTC_CS, Bus);
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Date and time struct - From DS1390 library
+DS1390DateTime Time;
+
+// Raw register values - digitalWrite test
+uint8_t Registers[8];
+
+/* ------------------------------------------------------------------------------------------- */
+// Auxiliary functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Mode 1 byte transfer using digitalWrite/digitalRead
+uint8_t slowTransfer (uint8_t Data)
+{
+  uint8_t Result = 0;
+
+  for (int8_t Bit = 7; Bit >= 0; Bit--)
+  {
+    digitalWrite (PIN_RTC_SCK, HIGH);
+    digitalWrite (PIN_RTC_MOSI, (Data >> Bit) & 0x01);
+    digitalWrite (PIN_RTC_SCK, LOW);
+    Result |= digitalRead (PIN_RTC_MISO) << Bit;
+  }
+
+  return Result;
+}
+
+// Date and time registers burst read using slowTransfer
+void slowRead ()
+{
+  digitalWrite (PIN_RTC_CS, LOW);
+  slowTransfer (DS1390_ADDR_READ_HSEC);
+
+  for (uint8_t Counter = 0; Counter < 8; Counter++)
+    Registers[Counter] = slowTransfer (0xFF);
+
+  digitalWrite (PIN_RTC_CS, HIGH);
+}
+
+// Prints test result
+void printResult (const char *Name, uint32_t Elapsed)
+{
+  Serial.print (Name);
+  Serial.print (": ");
+  Serial.print (Elapsed / ITERATIONS);
+  Serial.println (" us per read");
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Initialization function
+/* ------------------------------------------------------------------------------------------- */
+
+void setup()
+{
+  Serial.begin(74480);
+  while (!Serial);
+
+  Serial.println();
+  Serial.print (DS1390_CODE_NAME);
+  Serial.print (" library v");
+  Serial.println (DS1390_CODE_VERSION);
+
+  /* ----------------------------------------------------------------------------------------- */
+
+  uint32_t Start = 0;
+
+  // Hardware SPI bus
+  HardClock.begin ();
+
+  Start = micros ();
+  for (uint16_t Counter = 0; Counter < ITERATIONS; Counter++)
+    HardClock.getDateTimeAll (Time);
+  printResult ("Hardware SPI", micros () - Start);
+
+  // Release pins for the software tests
+  SPI.end ();
+
+  // DS1390SoftSpi bus - No powerup delay needed anymore
+  SoftClock.begin (false);
+
+  Start = micros ();
+  for (uint16_t Counter = 0; Counter < ITERATIONS; Counter++)
+    SoftClock.getDateTimeAll (Time);
+  printResult ("DS1390SoftSpi", micros () - Start);
+
+  // digitalWrite bus - Pins already configured by DS1390SoftSpi
+  Start = micros ();
+  for (uint16_t Counter = 0; Counter < ITERATIONS; Counter++)
+    slowRead ();
+  printResult ("digitalWrite", micros () - Start);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Loop function
+/* ------------------------------------------------------------------------------------------- */
+
+void loop()
+{
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
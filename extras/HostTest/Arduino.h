@@ -0,0 +1,125 @@
+/* ------------------------------------------------------------------------------------------- */
+// Arduino - Minimal Arduino core for the host tests in extras/HostTest
+//
+// Notes:   - Only what the library and its host tests use. Time and pins are simulated in
+//            DS1390Sim.cpp
+//          - micros() and millis() advance the simulated time by a few microseconds per call,
+//            so busy-wait loops terminate
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Program memory is plain memory on the host
+#define PROGMEM
+#define pgm_read_byte(p)         (*(const uint8_t *)(p))
+#define pgm_read_word(p)         (*(const uint16_t *)(p))
+#define pgm_read_dword(p)        (*(const uint32_t *)(p))
+
+// Pin values and modes
+#define LOW                      0
+#define HIGH                     1
+#define INPUT                    0
+#define OUTPUT                   1
+#define INPUT_PULLUP             2
+
+// Interrupt modes
+#define RISING                   3
+#define FALLING                  2
+#define CHANGE                   4
+
+// Interrupt control - No interrupts on the host
+#define noInterrupts()
+#define interrupts()
+#define digitalPinToInterrupt(p) (p)
+
+// Bit order
+#define MSBFIRST                 1
+
+// Clock of the AVR boards (used by the SPI clock selection)
+#ifndef F_CPU
+#define F_CPU                    16000000UL
+#endif
+
+// Arduino math macros
+#define min(a, b)                ((a) < (b) ? (a) : (b))
+#define max(a, b)                ((a) > (b) ? (a) : (b))
+#define constrain(x, low, high)  ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+/* ------------------------------------------------------------------------------------------- */
+// Types
+/* ------------------------------------------------------------------------------------------- */
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions - Defined in DS1390Sim.cpp
+/* ------------------------------------------------------------------------------------------- */
+
+uint32_t millis ();
+uint32_t micros ();
+void delay (uint32_t Ms);
+void delayMicroseconds (unsigned int Us);
+void yield ();
+void pinMode (uint8_t Pin, uint8_t Mode);
+void digitalWrite (uint8_t Pin, uint8_t Value);
+int digitalRead (uint8_t Pin);
+void attachInterrupt (uint8_t Interrupt, void (*Handler)(void), int Mode);
+void detachInterrupt (uint8_t Interrupt);
+
+/* ------------------------------------------------------------------------------------------- */
+// Serial port - Printed to stdout
+/* ------------------------------------------------------------------------------------------- */
+
+class HostSerial
+{
+  public:
+    void begin (long Baud) { (void)Baud; }
+    explicit operator bool () const { return true; }
+
+    void print (const char *Value) { fputs (Value, stdout); }
+    void print (int Value) { ::printf ("%d", Value); }
+    void print (unsigned int Value) { ::printf ("%u", Value); }
+    void print (long Value) { ::printf ("%ld", Value); }
+    void print (unsigned long Value) { ::printf ("%lu", Value); }
+    void print (double Value) { ::printf ("%.2f", Value); }
+
+    template <typename Type>
+    void println (Type Value) { print (Value); println (); }
+    void println () { fputs ("\n", stdout); }
+
+    void printf (const char *Format, ...)
+    {
+      va_list Arguments;
+      va_start (Arguments, Format);
+      vprintf (Format, Arguments);
+      va_end (Arguments);
+    }
+};
+
+extern HostSerial Serial;
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
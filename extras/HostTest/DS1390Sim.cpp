@@ -0,0 +1,254 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Sim - Simulated time and DS1390 device for the host tests in extras/HostTest
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "DS1390Sim.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Device registers
+uint8_t SimRegisters[16];
+
+// Simulated time (us)
+uint64_t SimMicros = 0;
+
+// Serial port and SPI bus objects
+HostSerial Serial;
+SPIClass SPI;
+
+// Transaction state - Address byte expected, write access and current address
+static bool AddressNext = true;
+static bool Writing = false;
+static uint8_t Address = 0;
+
+// Counter chain - Enabled, time written in this transaction, and its value (us since
+// 1970-01-01 in 24h format, years 2000 to 2099) at SimMicros = BaseMicros
+static bool Ticking = false;
+static bool TimeWritten = false;
+static uint64_t BaseTime = 0;
+static uint64_t BaseMicros = 0;
+
+// Century bit as last written - Kept by the counter
+static uint8_t Century = 0;
+
+/* ------------------------------------------------------------------------------------------- */
+// Auxiliary functions
+/* ------------------------------------------------------------------------------------------- */
+
+static uint8_t toDec (uint8_t Value)
+{
+  return (Value >> 4) * 10 + (Value & 0x0F);
+}
+
+static uint8_t toBcd (uint8_t Value)
+{
+  return ((Value / 10) << 4) | (Value % 10);
+}
+
+static bool isLeap (uint16_t Year)
+{
+  return ((Year % 4 == 0) && (Year % 100 != 0)) || (Year % 400 == 0);
+}
+
+static uint8_t monthDays (uint8_t Month, uint16_t Year)
+{
+  static const uint8_t Days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+  return Days[Month - 1] + ((Month == 2) && isLeap (Year));
+}
+
+// Restarts the counter chain from the date and time registers
+static void rebase ()
+{
+  const uint16_t Year = 2000 + toDec (SimRegisters[7]);
+  const uint8_t Month = toDec (SimRegisters[6] & 0x1F);
+  uint64_t Days = toDec (SimRegisters[5]) - 1;
+
+  for (uint16_t Index = 1970; Index < Year; Index++)
+    Days += isLeap (Index) ? 366 : 365;
+
+  for (uint8_t Index = 1; Index < Month; Index++)
+    Days += monthDays (Index, Year);
+
+  const uint64_t Seconds = Days * 86400 + toDec (SimRegisters[3] & 0x3F) * 3600 +
+                           toDec (SimRegisters[2]) * 60 + toDec (SimRegisters[1]);
+
+  Century = SimRegisters[6] & 0x80;
+  BaseTime = Seconds * 1000000 + toDec (SimRegisters[0]) * 10000ULL;
+  BaseMicros = SimMicros;
+}
+
+// Updates the date and time registers from the counter chain
+static void tick ()
+{
+  const uint64_t Time = BaseTime + (SimMicros - BaseMicros);
+  const uint64_t Seconds = Time / 1000000;
+  uint32_t Days = Seconds / 86400;
+
+  SimRegisters[0] = toBcd ((Time % 1000000) / 10000);
+  SimRegisters[1] = toBcd (Seconds % 60);
+  SimRegisters[2] = toBcd ((Seconds / 60) % 60);
+  SimRegisters[3] = toBcd ((Seconds / 3600) % 24);
+  SimRegisters[4] = toBcd ((Days + 4) % 7 + 1);
+
+  uint16_t Year = 1970;
+  while (Days >= (isLeap (Year) ? 366U : 365U))
+    Days -= isLeap (Year++) ? 366 : 365;
+
+  uint8_t Month = 1;
+  while (Days >= monthDays (Month, Year))
+    Days -= monthDays (Month++, Year);
+
+  SimRegisters[5] = toBcd (Days + 1);
+  SimRegisters[6] = toBcd (Month) | Century;
+  SimRegisters[7] = toBcd (Year % 100);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Simulation control
+/* ------------------------------------------------------------------------------------------- */
+
+void simStartTicking ()
+{
+  Ticking = true;
+  rebase ();
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Arduino core
+/* ------------------------------------------------------------------------------------------- */
+
+uint32_t millis ()
+{
+  SimMicros += SIM_CALL_US;
+  return SimMicros / 1000;
+}
+
+uint32_t micros ()
+{
+  SimMicros += SIM_CALL_US;
+  return (uint32_t)SimMicros;
+}
+
+void delay (uint32_t Ms)
+{
+  SimMicros += Ms * 1000ULL;
+}
+
+void delayMicroseconds (unsigned int Us)
+{
+  SimMicros += Us;
+}
+
+void yield ()
+{
+}
+
+void pinMode (uint8_t Pin, uint8_t Mode)
+{
+  (void)Pin;
+  (void)Mode;
+}
+
+void digitalWrite (uint8_t Pin, uint8_t Value)
+{
+  (void)Pin;
+  (void)Value;
+}
+
+int digitalRead (uint8_t Pin)
+{
+  (void)Pin;
+  return LOW;
+}
+
+void attachInterrupt (uint8_t Interrupt, void (*Handler)(void), int Mode)
+{
+  (void)Interrupt;
+  (void)Handler;
+  (void)Mode;
+}
+
+void detachInterrupt (uint8_t Interrupt)
+{
+  (void)Interrupt;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// SPI bus - Connected to the device
+/* ------------------------------------------------------------------------------------------- */
+
+void SPIClass::begin ()
+{
+}
+
+void SPIClass::beginTransaction (SPISettings Settings)
+{
+  (void)Settings;
+
+  // Address byte first
+  AddressNext = true;
+  TimeWritten = false;
+
+  // Device latches the counter at the start of a transaction
+  if (Ticking)
+    tick ();
+}
+
+void SPIClass::endTransaction ()
+{
+  // Counter restarts from the written time
+  if (Ticking && TimeWritten)
+    rebase ();
+}
+
+uint8_t SPIClass::transfer (uint8_t Data)
+{
+  SimMicros += SIM_BYTE_US;
+
+  // Address byte - Bit 7 set for writes
+  if (AddressNext)
+  {
+    AddressNext = false;
+    Writing = Data & 0x80;
+    Address = Data & 0x0F;
+    return 0xFF;
+  }
+
+  uint8_t Value = 0;
+
+  if (Writing)
+  {
+    SimRegisters[Address] = Data;
+    TimeWritten |= (Address < 8);
+  }
+
+  else
+    Value = SimRegisters[Address];
+
+  // Burst access
+  Address = (Address + 1) & 0x0F;
+  return Value;
+}
+
+void SPIClass::transfer (void *Buffer, size_t Length)
+{
+  uint8_t *Data = (uint8_t *)Buffer;
+
+  for (size_t Index = 0; Index < Length; Index++)
+    Data[Index] = transfer (Data[Index]);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
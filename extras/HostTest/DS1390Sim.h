@@ -0,0 +1,52 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Sim - Simulated time and DS1390 device for the host tests in extras/HostTest
+//
+// Notes:   - Time is a 64 bit microsecond counter. delay() and delayMicroseconds() advance it
+//            at once, micros() and millis() by SIM_CALL_US, each SPI byte by SIM_BYTE_US
+//          - The device is a plain register file until simStartTicking() is called. From then
+//            on, the date and time registers follow the simulated time like the real counter
+//            chain: a write to them restarts the count from the written value
+//          - Hardware SPI only. One transaction at a time (single bus owner)
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390Sim_h
+#define DS1390Sim_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Simulated time taken by a micros() or millis() call and by an SPI byte (us)
+#define SIM_CALL_US              3
+#define SIM_BYTE_US              4
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Device registers - Read addresses 0x00 to 0x0F
+extern uint8_t SimRegisters[16];
+
+// Simulated time (us)
+extern uint64_t SimMicros;
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Makes the date and time registers count from their current value
+void simStartTicking ();
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
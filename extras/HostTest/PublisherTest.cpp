@@ -0,0 +1,228 @@
+/* ------------------------------------------------------------------------------------------- */
+// PublisherTest - Stresses the DS1390Publisher seqlock with host threads
+//
+// Notes:   - One writer thread calls refresh() back to back, advancing the simulated RTC by
+//            SIM_STEP_MS before each one, so every publish changes the copy
+//          - READERS threads call read() and check each copy: the epoch must match the
+//            DateTime (torn copy), and neither the epoch nor the generation may go back
+//          - A timer signal delivered to the writer every SIGNAL_US runs the same check, like
+//            an interrupt preempting the refresher. It lands inside a publish often enough to
+//            exercise the seqlock even on a single core host
+//          - Failed reads (no consistent copy in DS1390_PUBLISHER_RETRIES attempts) are
+//            counted but are not errors
+//          - Exit status is 0 if no copy was torn or went back and some reads succeeded
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "Arduino.h"
+#include "DS1390Sim.h"
+#include "DS1390_SPI.h"
+#include "DS1390_Publisher.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Reader threads plus the signal handler, and writer iterations
+#define READERS                  3
+#define SLOTS                    (READERS + 1)
+#define REFRESHES                200000
+
+// Simulated time between two refreshes (ms)
+#define SIM_STEP_MS              370
+
+// Timer signal period (us)
+#define SIGNAL_US                50
+
+// Timezone of the published epoch - UTC-3
+#define TIMEZONE                 -3
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// RTC constructor
+DS1390 Clock (10);
+
+// Publisher constructor
+DS1390Publisher Publisher (Clock, TIMEZONE);
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Writer done
+volatile bool Done = false;
+
+// Results - One slot per reader thread, the last one for the signal handler
+uint32_t Reads[SLOTS];
+uint32_t Failures[SLOTS];
+uint32_t Torn[SLOTS];
+uint32_t Backwards[SLOTS];
+
+// Last values seen by each reader
+uint32_t LastEpoch[SLOTS];
+uint32_t LastGeneration[SLOTS];
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Writer thread - Only owner of the bus and the simulated time
+void *writerThread (void *Parameter)
+{
+  (void)Parameter;
+
+  // Timer signal is handled here only
+  sigset_t Signals;
+  sigemptyset (&Signals);
+  sigaddset (&Signals, SIGALRM);
+  pthread_sigmask (SIG_UNBLOCK, &Signals, nullptr);
+
+  for (uint32_t Count = 0; Count < REFRESHES; Count++)
+  {
+    delay (SIM_STEP_MS);
+    Publisher.refresh ();
+
+    // Let the readers catch the copy in different states
+    if ((Count & 0x3F) == 0)
+      sched_yield ();
+  }
+
+  __atomic_store_n (&Done, true, __ATOMIC_RELEASE);
+  return nullptr;
+}
+
+// Reads and checks one published copy
+void check (uint8_t Index)
+{
+  DS1390DateTime DateTime;
+  uint32_t Epoch;
+
+  // Generation first - Every copy read after it is at least as new
+  const uint32_t Generation = Publisher.getGeneration ();
+  if (Generation < LastGeneration[Index])
+    Backwards[Index]++;
+  LastGeneration[Index] = Generation;
+
+  // Published copy - No trim is set, so the epoch is the plain conversion of the DateTime
+  if (!Publisher.read (DateTime, &Epoch))
+    Failures[Index]++;
+
+  else
+  {
+    if (Clock.dateTimeToEpoch (DateTime, TIMEZONE) != Epoch)
+      Torn[Index]++;
+
+    if (Epoch < LastEpoch[Index])
+      Backwards[Index]++;
+
+    LastEpoch[Index] = Epoch;
+  }
+
+  Reads[Index]++;
+}
+
+// Reader thread - Parameter is the index in the results
+void *readerThread (void *Parameter)
+{
+  const uint8_t Index = (uintptr_t)Parameter;
+
+  while (!__atomic_load_n (&Done, __ATOMIC_ACQUIRE))
+    check (Index);
+
+  return nullptr;
+}
+
+// Timer signal - Preempts the writer like an interrupt
+void handleSignal (int Signal)
+{
+  (void)Signal;
+  check (READERS);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Main function
+/* ------------------------------------------------------------------------------------------- */
+
+int main ()
+{
+  // Valid date before the counter starts - Jan 1, 2026
+  SimRegisters[5] = 0x01;
+  SimRegisters[6] = 0x01;
+  SimRegisters[7] = 0x26;
+  simStartTicking ();
+
+  // First publish before the readers start
+  Clock.begin ();
+  Publisher.refresh ();
+
+  // Timer signal - Blocked in every thread but the writer
+  sigset_t Signals;
+  sigemptyset (&Signals);
+  sigaddset (&Signals, SIGALRM);
+  pthread_sigmask (SIG_BLOCK, &Signals, nullptr);
+
+  struct sigaction Action;
+  memset (&Action, 0, sizeof (Action));
+  Action.sa_handler = handleSignal;
+  sigaction (SIGALRM, &Action, nullptr);
+
+  struct itimerval Timer;
+  Timer.it_interval.tv_sec = 0;
+  Timer.it_interval.tv_usec = SIGNAL_US;
+  Timer.it_value = Timer.it_interval;
+  setitimer (ITIMER_REAL, &Timer, nullptr);
+
+  // Start threads
+  pthread_t Writer;
+  pthread_t Readers[READERS];
+
+  for (uintptr_t Index = 0; Index < READERS; Index++)
+    pthread_create (&Readers[Index], nullptr, readerThread, (void *)Index);
+
+  pthread_create (&Writer, nullptr, writerThread, nullptr);
+
+  // Wait for all of them
+  pthread_join (Writer, nullptr);
+
+  Timer.it_value.tv_usec = 0;
+  Timer.it_interval.tv_usec = 0;
+  setitimer (ITIMER_REAL, &Timer, nullptr);
+
+  for (uint8_t Index = 0; Index < READERS; Index++)
+    pthread_join (Readers[Index], nullptr);
+
+  // Results
+  uint32_t Errors = 0;
+  uint32_t Consistent = 0;
+
+  Serial.printf ("Generation %u \n", Publisher.getGeneration ());
+
+  for (uint8_t Index = 0; Index < SLOTS; Index++)
+  {
+    Serial.printf ("%s %u: %u reads, %u failed, %u torn, %u backwards \n",
+                   (Index < READERS) ? "Reader" : "Signal", Index,
+                   Reads[Index], Failures[Index], Torn[Index], Backwards[Index]);
+
+    Errors += Torn[Index] + Backwards[Index];
+    Consistent += Reads[Index] - Failures[Index];
+  }
+
+  Serial.println ((Errors == 0) && (Consistent > 0) ? "PASS" : "FAIL");
+
+  return (Errors == 0) && (Consistent > 0) ? 0 : 1;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
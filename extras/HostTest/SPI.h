@@ -0,0 +1,54 @@
+/* ------------------------------------------------------------------------------------------- */
+// SPI - Minimal Arduino SPI library for the host tests in extras/HostTest
+//
+// Notes:   - Transfers go to the simulated DS1390 in DS1390Sim.cpp
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef SPI_h
+#define SPI_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+#define SPI_MODE1                1
+
+/* ------------------------------------------------------------------------------------------- */
+// Classes
+/* ------------------------------------------------------------------------------------------- */
+
+class SPISettings
+{
+  public:
+    SPISettings () {}
+    SPISettings (uint32_t Clock, uint8_t BitOrder, uint8_t DataMode) : _Clock(Clock) { (void)BitOrder; (void)DataMode; }
+
+  private:
+    uint32_t _Clock = 0;
+};
+
+class SPIClass
+{
+  public:
+    void begin ();
+    void beginTransaction (SPISettings Settings);
+    void endTransaction ();
+    uint8_t transfer (uint8_t Data);
+    void transfer (void *Buffer, size_t Length);
+};
+
+extern SPIClass SPI;
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
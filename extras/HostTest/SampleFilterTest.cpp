@@ -0,0 +1,179 @@
+/* ------------------------------------------------------------------------------------------- */
+// SampleFilterTest - Checks DS1390SampleFilter against a synthetic reference clock
+//
+// Notes:   - The reference is the simulated time plus REFERENCE_OFFSET_US. The synthetic
+//            source stamps each reply at half its round-trip delay, plus the error of the
+//            sample, and takes the round-trip delay in simulated time
+//          - Outlier rejection: two samples with large errors have the smallest delays, so
+//            picking the minimum delay alone would choose them
+//          - Minimum-delay selection: the remaining samples have a small error that grows
+//            with the delay, so only the right sample sets the RTC within TOLERANCE_US. The
+//            error is measured at a hundredth edge
+//          - Exit status is the number of failed checks
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390Sim.h"
+#include "DS1390_SPI.h"
+#include "DS1390_SampleFilter.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Reference time at simulated time 0 (us since epoch) - RTC starts at Jan 1, 2026 00:00:00
+#define REFERENCE_OFFSET_US      (1767225600ULL * 1000000 + 1234567890ULL)
+
+// Largest error of the RTC against the reference after apply (us) - Error of the best sample,
+// its milliseconds truncation and the timing of the write and of the check. Every other inlier
+// is at least 4 ms off
+#define TOLERANCE_US             1500
+
+/* ------------------------------------------------------------------------------------------- */
+// Structures
+/* ------------------------------------------------------------------------------------------- */
+
+// Synthetic reply - Round-trip delay and error of the reference stamp (us)
+struct Reply
+{
+  uint32_t DelayMicros;
+  int32_t ErrorMicros;
+};
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// RTC constructor
+DS1390 Clock (10);
+
+// Filter constructor
+DS1390SampleFilter Filter;
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Replies in request order - 31 ms is the best sample
+const Reply Replies[] = {
+  { 48000,    4000 },
+  { 9000,   250000 },     // Outlier - Smallest delay
+  { 31000,     500 },     // Best
+  { 77000,    9000 },
+  { 12000,  -180000 },    // Outlier
+  { 39000,    4500 },
+  { 55000,    6000 },
+  { 64000,   -7000 }
+};
+
+#define REPLIES                  (sizeof(Replies) / sizeof(Replies[0]))
+
+// Next reply
+uint8_t Next = 0;
+
+// Failed checks
+uint16_t Failures = 0;
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions
+/* ------------------------------------------------------------------------------------------- */
+
+// Reference time at the given simulated time (us since epoch)
+uint64_t reference (uint64_t Micros)
+{
+  return REFERENCE_OFFSET_US + Micros;
+}
+
+// Synthetic sample source
+bool syntheticSample (DS1390Sample &Sample)
+{
+  if (Next >= REPLIES)
+    return false;
+
+  const Reply &Current = Replies[Next++];
+
+  // Reply stamped halfway through the round trip
+  const uint64_t Stamp = reference (SimMicros + Current.DelayMicros / 2) + Current.ErrorMicros;
+  delayMicroseconds (Current.DelayMicros);
+
+  Sample.Epoch = Stamp / 1000000;
+  Sample.Milliseconds = (Stamp % 1000000) / 1000;
+  Sample.DelayMicros = Current.DelayMicros;
+  Sample.CaptureMicros = micros ();
+
+  return true;
+}
+
+// Counts and prints a failed check
+void check (bool Passed, const char *Name, long Value)
+{
+  if (Passed)
+    return;
+
+  Failures++;
+  Serial.printf ("  FAIL: %s (%ld) \n", Name, Value);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Main function
+/* ------------------------------------------------------------------------------------------- */
+
+int main ()
+{
+  // Valid date before the counter starts - Jan 1, 2026
+  SimRegisters[5] = 0x01;
+  SimRegisters[6] = 0x01;
+  SimRegisters[7] = 0x26;
+  simStartTicking ();
+
+  Clock.begin ();
+
+  // Empty filter
+  DS1390Sample Best;
+  check (!Filter.getBest (Best), "empty getBest", 0);
+  check (!Filter.apply (Clock, 0), "empty apply", 0);
+
+  // Samples far apart are rejected
+  DS1390Sample Far;
+  Far.Epoch = 1000;
+  check (Filter.addSample (Far), "first sample", 0);
+  Far.Epoch += DS1390_FILTER_MAX_SPAN_S + 1;
+  check (!Filter.addSample (Far), "span limit", Far.Epoch);
+  Filter.reset ();
+
+  // Every synthetic reply is stored
+  check (Filter.collect (syntheticSample, REPLIES, 100) == REPLIES, "collect", Filter.getSamples ());
+
+  // Outliers rejected, smallest delay of the rest
+  check (Filter.getBest (Best), "getBest", 0);
+  check (Best.DelayMicros == 31000, "best delay", Best.DelayMicros);
+
+  // RTC set on time, within the error of the best sample
+  check (Filter.apply (Clock, 0), "apply on time", 0);
+
+  // Measured right after a hundredth edge, so the RTC time is exact
+  const uint8_t Hsecond = Clock.getDateTimeHSeconds ();
+  while (Clock.getDateTimeHSeconds () == Hsecond);
+
+  uint16_t Milliseconds;
+  const uint32_t Now = micros ();
+  const uint32_t Epoch = Clock.getDateTimeEpoch (0, &Milliseconds);
+  const int64_t Error = ((int64_t)Epoch * 1000 + Milliseconds) * 1000 - (int64_t)reference (Now);
+
+  Serial.printf ("RTC error after apply: %ld us \n", (long)Error);
+  check ((Error < TOLERANCE_US) && (Error > -TOLERANCE_US), "RTC error (us)", (long)Error);
+
+  Serial.printf ("Failed checks: %u \n", Failures);
+
+  return Failures;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
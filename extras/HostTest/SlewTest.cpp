@@ -0,0 +1,39 @@
+/* ------------------------------------------------------------------------------------------- */
+// SlewTest - Runs the SlewConvergence example on the simulated DS1390
+//
+// Notes:   - The simulated RTC and micros() share one time base, so the synthetic reference
+//            of the example is exact and the run is deterministic
+//          - Exit status is the number of failed checks
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390Sim.h"
+#include "../../examples/SlewConvergence/SlewConvergence.ino"
+
+/* ------------------------------------------------------------------------------------------- */
+// Main function
+/* ------------------------------------------------------------------------------------------- */
+
+int main ()
+{
+  // Valid date before the counter starts - Jan 1, 2026
+  SimRegisters[5] = 0x01;
+  SimRegisters[6] = 0x01;
+  SimRegisters[7] = 0x26;
+  simStartTicking ();
+
+  // Whole example
+  setup ();
+
+  return Failures;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
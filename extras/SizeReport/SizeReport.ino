@@ -0,0 +1,77 @@
+/* ------------------------------------------------------------------------------------------- */
+// SizeReport - Footprint probe for extras/size_report.sh. Calls one function of each feature
+//              that is enabled, so the linker keeps exactly the code a feature brings in
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Libraries
+/* ------------------------------------------------------------------------------------------- */
+
+#include "DS1390_SPI.h" // https://github.com/duarterr/Arduino-DS1390-SPI
+
+/* ------------------------------------------------------------------------------------------- */
+// Hardware defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Peripheral pins
+#define PIN_RTC_CS               10
+
+/* ------------------------------------------------------------------------------------------- */
+// Constructor
+/* ------------------------------------------------------------------------------------------- */
+
+// RTC constructor
+DS1390 Clock (PIN_RTC_CS);
+
+/* ------------------------------------------------------------------------------------------- */
+// Variables
+/* ------------------------------------------------------------------------------------------- */
+
+// Date and time struct - From DS1390 library
+DS1390DateTime Time;
+
+// Results are stored here so the calls are not optimized away
+volatile uint32_t Sink;
+
+/* ------------------------------------------------------------------------------------------- */
+// Initialization function
+/* ------------------------------------------------------------------------------------------- */
+
+void setup()
+{
+  // Core - Always present
+  Clock.begin ();
+  Clock.getDateTimeAll (Time);
+  Clock.setDateTimeAll (Time);
+
+#if DS1390_ENABLE_12H
+  Sink = Clock.getDateTimeAmPm ();
+#endif
+
+#if DS1390_ENABLE_SETTERS
+  Clock.setDateTimeMinutes (Time.Minute);
+#endif
+
+#if DS1390_ENABLE_EPOCH
+  Sink = Clock.getDateTimeEpoch (0);
+  Clock.setDateTimeEpoch (Sink, 0);
+#endif
+
+#if DS1390_ENABLE_TRICKLE
+  Clock.setTrickleChargerMode (DS1390_TCH_250_D);
+#endif
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// Main loop
+/* ------------------------------------------------------------------------------------------- */
+
+void loop()
+{
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
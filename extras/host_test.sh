@@ -0,0 +1,45 @@
+#!/bin/sh
+# ---------------------------------------------------------------------------------------------
+# host_test.sh - Builds and runs the host tests of the DS1390 library
+#
+# Usage:   extras/host_test.sh [TEST...]   (default: every extras/HostTest/*Test.cpp)
+# Needs:   g++ with pthread support
+#
+# Each test is linked with the library sources and the simulated Arduino core and DS1390
+# device in extras/HostTest. A test passes when it exits with status 0.
+# ---------------------------------------------------------------------------------------------
+
+CXX=${CXX:-g++}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+DIR="$ROOT/extras/HostTest"
+BUILD=$(mktemp -d)
+trap 'rm -rf "$BUILD"' EXIT
+
+if [ $# -eq 0 ]
+then
+  set -- $(cd "$DIR" && ls *Test.cpp | sed 's/\.cpp$//')
+fi
+
+FAILED=0
+
+for TEST in "$@"
+do
+  if ! $CXX -std=gnu++11 -O1 -Wall -pthread -I"$DIR" -I"$ROOT/src" -o "$BUILD/$TEST" \
+       "$DIR/$TEST.cpp" "$DIR/DS1390Sim.cpp" "$ROOT"/src/*.cpp
+  then
+    printf '%-20s %s\n' "$TEST" "BUILD FAILED"
+    FAILED=$((FAILED + 1))
+    continue
+  fi
+
+  if OUTPUT=$("$BUILD/$TEST" 2>&1)
+  then
+    printf '%-20s %s\n' "$TEST" "PASS"
+  else
+    printf '%-20s %s\n' "$TEST" "FAIL"
+    echo "$OUTPUT" >&2
+    FAILED=$((FAILED + 1))
+  fi
+done
+
+exit $FAILED
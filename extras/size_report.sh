@@ -0,0 +1,45 @@
+#!/bin/sh
+# ---------------------------------------------------------------------------------------------
+# size_report.sh - Flash and RAM footprint of the DS1390 library per feature configuration
+#
+# Usage:   extras/size_report.sh [FQBN]   (default: arduino:avr:uno)
+# Needs:   arduino-cli with the core for FQBN installed
+#
+# Builds extras/SizeReport once per configuration, passing the DS1390_ENABLE_* and
+# DS1390_TIME_FORMAT flags as build properties, and prints the sizes reported by arduino-cli.
+# ---------------------------------------------------------------------------------------------
+
+FQBN=${1:-arduino:avr:uno}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+SKETCH="$ROOT/extras/SizeReport"
+
+# Name|Flags
+CONFIGS="all|
+24h only|-DDS1390_TIME_FORMAT=DS1390_FORMAT_24H
+12h only|-DDS1390_TIME_FORMAT=DS1390_FORMAT_12H
+no setters|-DDS1390_ENABLE_SETTERS=0
+no epoch|-DDS1390_ENABLE_EPOCH=0
+no trickle|-DDS1390_ENABLE_TRICKLE=0
+no anchor|-DDS1390_ENABLE_TRIM_ANCHOR=0
+year table|-DDS1390_ENABLE_YEAR_TABLE=1
+core only|-DDS1390_ENABLE_12H=0 -DDS1390_ENABLE_SETTERS=0 -DDS1390_ENABLE_EPOCH=0 -DDS1390_ENABLE_TRICKLE=0 -DDS1390_ENABLE_TRIM_ANCHOR=0"
+
+printf '%-12s %10s %10s\n' "Config" "Flash" "RAM"
+
+echo "$CONFIGS" | while IFS='|' read -r NAME FLAGS
+do
+  OUTPUT=$(arduino-cli compile --fqbn "$FQBN" --library "$ROOT" --clean \
+           --build-property "compiler.cpp.extra_flags=$FLAGS" "$SKETCH" 2>&1)
+
+  if [ $? -ne 0 ]
+  then
+    printf '%-12s %10s\n' "$NAME" "FAILED"
+    echo "$OUTPUT" >&2
+    continue
+  fi
+
+  FLASH=$(echo "$OUTPUT" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+  RAM=$(echo "$OUTPUT" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+
+  printf '%-12s %10s %10s\n' "$NAME" "$FLASH" "$RAM"
+done
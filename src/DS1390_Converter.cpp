@@ -0,0 +1,82 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Converter - Epoch to date conversion with a one-day cache
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_Converter.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Built on epoch conversions - Left out with DS1390_ENABLE_EPOCH
+#if DS1390_ENABLE_EPOCH
+
+// Name:        reset
+// Description: Clears the cached day - The next conversion is a full one
+// Arguments:   none
+// Returns:     none
+
+void DS1390Converter::reset ()
+{
+  _Day = 0xFFFFFFFF;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        epochToDateTime
+// Description: Converts Epoch timestamp to DS1390DateTime structure - Ignores hundredths of sec.
+//              The date is taken from the cache if the epoch falls on the cached day
+// Arguments:   Epoch - Epoch timestamp
+//              DateTime - DS1390DateTime structure to store the data
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of Epoch
+// Returns:     None
+
+void DS1390Converter::epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, DS1390Timezone Timezone)
+{
+  // Correct value for given timezone
+  const uint32_t EpochTime = Epoch + Timezone.Seconds;
+
+  // Day number and time of day
+  const uint32_t Day = EpochTime / 86400;
+
+  // Other day - Full conversion, then cache the date
+  if (Day != _Day)
+  {
+    _Clock.epochToDateTime (Epoch, DateTime, Timezone);
+
+    _Day = Day;
+    _Year = DateTime.Year;
+    _Month = DateTime.Month;
+    _MonthDay = DateTime.Day;
+    _Wday = DateTime.Wday;
+    return;
+  }
+
+  // Same day - Split time of day only
+  uint32_t Seconds = EpochTime - Day * 86400;
+  DateTime.Second = Seconds % 60;
+  Seconds /= 60;
+  DateTime.Minute = Seconds % 60;
+
+  // Hours in the current time format
+  _Clock.hourFrom24h (Seconds / 60, DateTime);
+
+  // Cached date
+  DateTime.Year = _Year;
+  DateTime.Month = _Month;
+  DateTime.Day = _MonthDay;
+  DateTime.Wday = _Wday;
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
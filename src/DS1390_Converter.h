@@ -0,0 +1,59 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Converter - Epoch to date conversion with a one-day cache
+//
+// Notes:   - Keeps the date (year, month, day and week day) of the last converted day. Epochs
+//            within the same day only split the time of day - Other days go through
+//            DS1390::epochToDateTime and replace the cached date
+//          - Meant for mostly increasing timestamps, such as log entries
+//          - Hours follow the time format of the DS1390 object, as in epochToDateTime
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_Converter_h
+#define DS1390_Converter_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SPI.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Converter class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390Converter
+{
+  public:
+    // Constructor
+    DS1390Converter (DS1390 &Clock)
+      : _Clock(Clock)         // Save RTC object
+    {}
+
+    // Clears the cached day
+    void reset ();
+
+    // Same as DS1390::epochToDateTime
+    void epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, DS1390Timezone Timezone);
+
+  private:
+    // RTC object - Time format and full conversions
+    DS1390 &_Clock;
+
+    // Cached day - Days since Jan 1, 1970 of the timezone corrected epoch (0xFFFFFFFF = none)
+    uint32_t _Day = 0xFFFFFFFF;
+
+    // Date of the cached day
+    uint16_t _Year = 0;
+    uint8_t _Month = 0;
+    uint8_t _MonthDay = 0;
+    uint8_t _Wday = 0;
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -0,0 +1,142 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Drift - RTC drift estimator
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_Drift.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Built on epoch conversions - Left out with DS1390_ENABLE_EPOCH
+#if DS1390_ENABLE_EPOCH
+
+// Name:        reset
+// Description: Clears all samples
+// Arguments:   none
+// Returns:     none
+
+void DS1390Drift::reset ()
+{
+  _Samples = 0;
+  _FirstReference = 0;
+  _MeanX = 0;
+  _MeanY = 0;
+  _Cxx = 0;
+  _Cxy = 0;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        addSample
+// Description: Adds an offset sample to the least-squares fit
+// Arguments:   Reference - Reference epoch timestamp when the offset was measured
+//              OffsetMs - RTC time minus reference time, in milliseconds
+// Returns:     none
+
+void DS1390Drift::addSample (uint32_t Reference, int32_t OffsetMs)
+{
+  // First sample sets time origin
+  if (_Samples == 0)
+    _FirstReference = Reference;
+
+  // Sample coordinates - Seconds since first sample and offset in ms
+  const float X = (float)(int32_t)(Reference - _FirstReference);
+  const float Y = (float)OffsetMs;
+
+  // Update means and co-moments
+  _Samples++;
+
+  const float DeltaX = X - _MeanX;
+  _MeanX += DeltaX / _Samples;
+  _MeanY += (Y - _MeanY) / _Samples;
+  _Cxx += DeltaX * (X - _MeanX);
+  _Cxy += DeltaX * (Y - _MeanY);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        addSample
+// Description: Reads the RTC and adds its offset to a reference time taken just before
+// Arguments:   Clock - Initialized DS1390 object
+//              Reference - Reference epoch timestamp
+//              ReferenceMs - Milliseconds of the reference (0 to 999)
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of Reference
+// Returns:     none
+
+void DS1390Drift::addSample (DS1390 &Clock, uint32_t Reference, uint16_t ReferenceMs, DS1390Timezone Timezone)
+{
+  // RTC time
+  uint16_t Milliseconds = 0;
+  const uint32_t Epoch = Clock.getDateTimeEpoch (Timezone, &Milliseconds);
+
+  // Offset in ms
+  addSample (Reference, ((int32_t)(Epoch - Reference) * 1000) + Milliseconds - ReferenceMs);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getSamples
+// Description: Gets the number of samples in the fit
+// Arguments:   none
+// Returns:     Number of samples
+
+uint32_t DS1390Drift::getSamples () const
+{
+  return _Samples;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getPpm
+// Description: Gets the estimated drift
+// Arguments:   none
+// Returns:     Drift in ppm (positive = RTC runs fast) - 0 if the samples span no time
+
+float DS1390Drift::getPpm () const
+{
+  // Not enough spread for a slope
+  if (_Cxx <= 0)
+    return 0;
+
+  // Slope in ms/s = ppm / 1000
+  return (_Cxy / _Cxx) * 1000;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        apply
+// Description: Adds the estimated drift to the trim stored in the DS1390 and clears the samples.
+//              The samples must have been taken with the current trim in effect
+// Arguments:   Clock - Initialized DS1390 object
+// Returns:     false if there are less than 2 samples or true on completion
+
+bool DS1390Drift::apply (DS1390 &Clock)
+{
+  // At least two samples are needed
+  if (_Samples < 2)
+    return false;
+
+  // Update trim - Rounded to whole ppm
+  const int16_t Trim = Clock.getTrim () + (int16_t)lround (getPpm ());
+  Clock.setTrim (constrain(Trim, DS1390_TRIM_MIN, DS1390_TRIM_MAX));
+
+  // Start a new fit
+  reset ();
+
+  // Success
+  return true;
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -0,0 +1,61 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Drift - RTC drift estimator
+//
+// Notes:   - Each sample is the offset between the RTC and a reference clock (NTP, GPS, host)
+//          - The drift is the least-squares slope of offset versus reference time
+//          - Do not set the RTC between samples of the same fit
+//          - apply() adds the estimate to the trim stored in the DS1390 (see DS1390::setTrim)
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_Drift_h
+#define DS1390_Drift_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SPI.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Drift class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390Drift
+{
+  public:
+    // Clears all samples
+    void reset ();
+
+    // Sample input
+    void addSample (uint32_t Reference, int32_t OffsetMs);
+    void addSample (DS1390 &Clock, uint32_t Reference, uint16_t ReferenceMs, DS1390Timezone Timezone);
+
+    // Estimate
+    uint32_t getSamples () const;
+    float getPpm () const;
+
+    // Stores the estimate in the DS1390 trim
+    bool apply (DS1390 &Clock);
+
+  private:
+    // Number of samples
+    uint32_t _Samples = 0;
+
+    // First reference time - Samples are taken relative to it to keep float precision
+    uint32_t _FirstReference = 0;
+
+    // Running means and co-moments (Welford)
+    float _MeanX = 0;
+    float _MeanY = 0;
+    float _Cxx = 0;
+    float _Cxy = 0;
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
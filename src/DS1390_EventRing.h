@@ -0,0 +1,172 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_EventRing - Interrupt-safe event timestamp buffer for the DS1390 RTC
+//
+// Notes:   - Single producer (one interrupt) and single consumer (loop or one task)
+//          - push() only stores micros() and an event ID - No SPI access, no locks
+//          - Entries are converted to RTC time later, in bulk, with a DS1390Monotonic clock.
+//            Convert entries at least every 35 minutes (half the micros() wraparound period)
+//          - convert() reads the RTC again when the clock anchor is older than
+//            DS1390_EVENTRING_ANCHOR_MS. Error is the MCU oscillator tolerance times the anchor
+//            age plus the event age (at 100 ppm and the default period, up to 6 ms plus 0.1 ms
+//            per second the event waited)
+//          - Size must be a power of 2 up to 128
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_EventRing_h
+#define DS1390_EventRing_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_Monotonic.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Maximum anchor age before convert() reads the RTC again
+#ifndef DS1390_EVENTRING_ANCHOR_MS
+#define DS1390_EVENTRING_ANCHOR_MS 60000
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// Structures
+/* ------------------------------------------------------------------------------------------- */
+
+// Event as stored by the interrupt
+struct DS1390Event
+{
+  uint32_t Micros;              // micros() when the event happened
+  uint8_t Id;                   // Event ID
+};
+
+// Event converted to RTC time
+struct DS1390EventTime
+{
+  uint32_t Epoch = 0;           // Epoch timestamp (GMT)
+  uint16_t Milliseconds = 0;    // Milliseconds (0 to 999)
+  uint8_t Id = 0;               // Event ID
+};
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390EventRing class
+/* ------------------------------------------------------------------------------------------- */
+
+template <uint8_t Size>
+class DS1390EventRing
+{
+  static_assert((Size != 0) && (Size <= 128) && ((Size & (Size - 1)) == 0), "Size must be a power of 2 up to 128");
+
+  public:
+    // Name:        push
+    // Description: Stores an event - Call from the interrupt routine
+    // Arguments:   Id - Event ID
+    // Returns:     false if the buffer is full (event dropped) or true on completion
+
+    bool push (uint8_t Id)
+    {
+      // Indexes - Head is only written here
+      const uint8_t Head = _Head;
+      const uint8_t Tail = __atomic_load_n (&_Tail, __ATOMIC_ACQUIRE);
+
+      // Buffer full
+      if ((uint8_t)(Head - Tail) >= Size)
+      {
+        _Dropped++;
+        return false;
+      }
+
+      // Store entry, then publish it
+      _Entries[Head & (Size - 1)].Micros = micros ();
+      _Entries[Head & (Size - 1)].Id = Id;
+      __atomic_store_n (&_Head, (uint8_t)(Head + 1), __ATOMIC_RELEASE);
+
+      // Success
+      return true;
+    }
+
+    // Name:        pop
+    // Description: Removes the oldest event without conversion
+    // Arguments:   Event - Structure to store the event
+    // Returns:     false if the buffer is empty or true on completion
+
+    bool pop (DS1390Event &Event)
+    {
+      // Indexes - Tail is only written here
+      const uint8_t Tail = _Tail;
+      const uint8_t Head = __atomic_load_n (&_Head, __ATOMIC_ACQUIRE);
+
+      // Buffer empty
+      if (Head == Tail)
+        return false;
+
+      // Read entry, then release its slot
+      Event.Micros = _Entries[Tail & (Size - 1)].Micros;
+      Event.Id = _Entries[Tail & (Size - 1)].Id;
+      __atomic_store_n (&_Tail, (uint8_t)(Tail + 1), __ATOMIC_RELEASE);
+
+      // Success
+      return true;
+    }
+
+    // Name:        convert
+    // Description: Removes up to Length events and converts them to RTC time. Reads the RTC
+    //              again first if the clock anchor is older than DS1390_EVENTRING_ANCHOR_MS
+    // Arguments:   Clock - Monotonic clock anchored to the RTC
+    //              Events - Array to store the converted events
+    //              Length - Array length
+    // Returns:     Number of events converted
+
+    uint8_t convert (DS1390Monotonic &Clock, DS1390EventTime *Events, uint8_t Length)
+    {
+      // Raw event
+      DS1390Event Event;
+
+      // Number of events
+      uint8_t Count = 0;
+
+      // Limit the MCU oscillator drift since the last RTC read
+      Clock.reanchor (DS1390_EVENTRING_ANCHOR_MS);
+
+      while ((Count < Length) && pop (Event))
+      {
+        Events[Count].Id = Event.Id;
+        Events[Count].Epoch = Clock.microsToEpoch (Event.Micros, &Events[Count].Milliseconds);
+        Count++;
+      }
+
+      // Return number of events
+      return Count;
+    }
+
+    // Name:        getDropped
+    // Description: Gets the number of events dropped because the buffer was full
+    // Arguments:   none
+    // Returns:     Number of events dropped
+
+    uint16_t getDropped () const
+    {
+      return _Dropped;
+    }
+
+  private:
+    // Entries
+    DS1390Event _Entries[Size];
+
+    // Free running indexes - Written by producer (head) and consumer (tail) only
+    volatile uint8_t _Head = 0;
+    volatile uint8_t _Tail = 0;
+
+    // Events dropped - Written by producer only
+    volatile uint16_t _Dropped = 0;
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
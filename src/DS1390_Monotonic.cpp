@@ -0,0 +1,215 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Monotonic - Monotonic clock anchored to the DS1390 RTC
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_Monotonic.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Built on epoch conversions - Left out with DS1390_ENABLE_EPOCH
+#if DS1390_ENABLE_EPOCH
+
+// Name:        begin
+// Description: Reads the RTC and anchors the monotonic clock to it
+// Arguments:   Clock - Initialized DS1390 object
+// Returns:     none
+
+void DS1390Monotonic::begin (DS1390 &Clock)
+{
+  // Save RTC object
+  _Clock = &Clock;
+
+  // Start counting
+  _LastMicros = micros ();
+  _LastMillis = millis ();
+  _Elapsed = 0;
+  _Served = 0;
+
+  // First anchor
+  reanchor ();
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        reanchor
+// Description: Reads the RTC again and anchors the epoch to it, removing the MCU oscillator
+//              drift accumulated since the last read. Elapsed time is not changed
+// Arguments:   MaxAgeMs - Read only if the anchor is older than this (0 = always)
+// Returns:     false if begin() was not called or the anchor is still recent, true if the RTC
+//              was read
+
+bool DS1390Monotonic::reanchor (uint32_t MaxAgeMs)
+{
+  // Not started
+  if (_Clock == nullptr)
+    return false;
+
+  // Anchor still recent
+  if ((MaxAgeMs != 0) && (getAnchorAge () < MaxAgeMs))
+    return false;
+
+  // Read a consistent snapshot
+  DS1390DateTime DateTime;
+  _Clock->getDateTimeSnapshot (DateTime);
+
+  // Capture MCU counters right after the read
+  update ();
+  _AnchorElapsed = _Elapsed;
+
+  // Save anchor - Trimmed like getDateTimeEpoch
+  _AnchorEpoch = _Clock->dateTimeToTrimmedEpoch (DateTime, 0, &_AnchorMillis);
+
+  // Success
+  return true;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getAnchorAge
+// Description: Gets the time elapsed since the RTC was last read
+// Arguments:   none
+// Returns:     Milliseconds since the last anchor read - Limited to 49 days
+
+uint32_t DS1390Monotonic::getAnchorAge ()
+{
+  const uint64_t Age = (getMicros () - _AnchorElapsed) / 1000;
+
+  return (Age < 0xFFFFFFFFULL) ? (uint32_t)Age : 0xFFFFFFFFUL;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        epochMillis
+// Description: Gets the anchor epoch in milliseconds advanced to the given elapsed time
+// Arguments:   Elapsed - Microseconds since begin() (may be before the anchor)
+// Returns:     Epoch timestamp in milliseconds
+
+uint64_t DS1390Monotonic::epochMillis (uint64_t Elapsed) const
+{
+  return (uint64_t)_AnchorEpoch * 1000 + _AnchorMillis + (int64_t)(Elapsed - _AnchorElapsed) / 1000;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        update
+// Description: Accumulates the time elapsed since the last call. micros() may have wrapped
+//              more than once - The number of wraps is recovered from millis()
+// Arguments:   none
+// Returns:     none
+
+void DS1390Monotonic::update ()
+{
+  // Current counters
+  const uint32_t Micros = micros ();
+  const uint32_t Millis = millis ();
+
+  // Elapsed time according to each counter (unsigned math handles a single wrap)
+  uint64_t Delta = (uint32_t)(Micros - _LastMicros);
+  const uint64_t DeltaMillis = (uint32_t)(Millis - _LastMillis);
+
+  // Add whole micros() periods missed (2^32 us ~ 71.6 min)
+  while ((Delta + 0x80000000ULL) < (DeltaMillis * 1000))
+    Delta += 0x100000000ULL;
+
+  // Accumulate - Never decreases
+  _Elapsed += Delta;
+
+  // Save counters
+  _LastMicros = Micros;
+  _LastMillis = Millis;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getMicros
+// Description: Gets the time elapsed since begin() without accessing the SPI bus
+// Arguments:   none
+// Returns:     Microseconds since begin()
+
+uint64_t DS1390Monotonic::getMicros ()
+{
+  // Update counters
+  update ();
+
+  // Return elapsed time
+  return _Elapsed;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getMillis
+// Description: Gets the time elapsed since begin() without accessing the SPI bus
+// Arguments:   none
+// Returns:     Milliseconds since begin() - Wraps after 49 days
+
+uint32_t DS1390Monotonic::getMillis ()
+{
+  // Return elapsed time
+  return (uint32_t)(getMicros () / 1000);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getEpoch
+// Description: Gets the RTC time of the last anchor read advanced by the elapsed time. Never
+//              goes backwards - Held at the last value served while a new anchor is behind it
+// Arguments:   Milliseconds - Optional pointer to store the milliseconds (0 to 999)
+// Returns:     Epoch timestamp (GMT)
+
+uint32_t DS1390Monotonic::getEpoch (uint16_t *Milliseconds)
+{
+  // Epoch in milliseconds - Not below the last value served
+  uint64_t Total = epochMillis (getMicros ());
+
+  if (Total < _Served)
+    Total = _Served;
+
+  _Served = Total;
+
+  // Milliseconds
+  if (Milliseconds != nullptr)
+    *Milliseconds = Total % 1000;
+
+  // Return epoch
+  return (uint32_t)(Total / 1000);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        microsToEpoch
+// Description: Converts a micros() value captured earlier (e.g. in an interrupt) to RTC time,
+//              using the last anchor read
+// Arguments:   Micros - micros() value, less than 35 minutes old (or in the future)
+//              Milliseconds - Optional pointer to store the milliseconds (0 to 999)
+// Returns:     Epoch timestamp (GMT)
+
+uint32_t DS1390Monotonic::microsToEpoch (uint32_t Micros, uint16_t *Milliseconds)
+{
+  // Update counters
+  update ();
+
+  // Epoch in milliseconds when micros() had the given value
+  const uint64_t Total = epochMillis (_Elapsed + (int32_t)(Micros - _LastMicros));
+
+  // Milliseconds
+  if (Milliseconds != nullptr)
+    *Milliseconds = Total % 1000;
+
+  // Return epoch
+  return (uint32_t)(Total / 1000);
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
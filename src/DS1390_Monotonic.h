@@ -0,0 +1,81 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Monotonic - Monotonic clock anchored to the DS1390 RTC
+//
+// Notes:   - The RTC is read in begin() and again by reanchor(). Reads in between use micros()
+//            and millis(), so the epoch drifts with the MCU oscillator by its tolerance times
+//            the anchor age (at 100 ppm, 6 ms per minute or 360 ms per hour). Call reanchor()
+//            periodically to bound it
+//          - Elapsed time never goes backwards. getEpoch() holds if a new anchor is behind the
+//            time already served, until it catches up. begin() starts over
+//          - micros() wraparound is handled as long as one of the getters is called at least
+//            once every 49 days (millis() wraparound period)
+//          - Not safe to call from interrupts
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_Monotonic_h
+#define DS1390_Monotonic_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SPI.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Monotonic class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390Monotonic
+{
+  public:
+    // Initializer - Reads the RTC anchor
+    void begin (DS1390 &Clock);
+
+    // Reads the RTC anchor again
+    bool reanchor (uint32_t MaxAgeMs = 0);
+    uint32_t getAnchorAge ();
+
+    // Elapsed time since begin()
+    uint64_t getMicros ();
+    uint32_t getMillis ();
+
+    // Anchor epoch (GMT) advanced by the elapsed time
+    uint32_t getEpoch (uint16_t *Milliseconds = nullptr);
+
+    // Converts a recent micros() value (less than 35 minutes old) to epoch (GMT)
+    uint32_t microsToEpoch (uint32_t Micros, uint16_t *Milliseconds = nullptr);
+
+  private:
+    // RTC object
+    DS1390 *_Clock = nullptr;
+
+    // RTC time at the last anchor read - Epoch (GMT), milliseconds and the elapsed time then
+    uint32_t _AnchorEpoch = 0;
+    uint16_t _AnchorMillis = 0;
+    uint64_t _AnchorElapsed = 0;
+
+    // Last epoch served by getEpoch() in milliseconds - Holds it across a new anchor
+    uint64_t _Served = 0;
+
+    // MCU counters at last update
+    uint32_t _LastMicros = 0;
+    uint32_t _LastMillis = 0;
+
+    // Microseconds elapsed since begin()
+    uint64_t _Elapsed = 0;
+
+    // Counter update
+    void update ();
+
+    // Epoch in milliseconds at the given elapsed time
+    uint64_t epochMillis (uint64_t Elapsed) const;
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
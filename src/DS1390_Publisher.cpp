@@ -0,0 +1,233 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Publisher - Lock-free shared RTC time for multi-task readers
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_Publisher.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Built on epoch conversions - Left out with DS1390_ENABLE_EPOCH
+#if DS1390_ENABLE_EPOCH
+
+// Name:        waitRefresh
+// Description: Lets a refresh in progress finish before a reader tries again. On ESP32 tasks,
+//              blocks for one tick so that a refresher with lower priority on the same core can
+//              run. Interrupts and other targets try again at once
+// Arguments:   none
+// Returns:     none
+
+static void waitRefresh ()
+{
+#if defined(ESP32)
+  if (!xPortInIsrContext ())
+    vTaskDelay (1);
+#endif
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+#if defined(ESP32)
+
+// Name:        begin
+// Description: Starts a FreeRTOS task that refreshes the published time periodically
+// Arguments:   PeriodMs - Refresh period
+// Returns:     false if the task could not be created or true on completion
+
+bool DS1390Publisher::begin (uint16_t PeriodMs)
+{
+  // Save period
+  _PeriodMs = PeriodMs;
+
+  // First refresh - Readers have data as soon as begin() returns
+  refresh ();
+
+  // Create task
+  return xTaskCreate (task, "DS1390", DS1390_PUBLISHER_STACK, this, DS1390_PUBLISHER_PRIORITY, nullptr) == pdPASS;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        task
+// Description: Refresher task body
+// Arguments:   Parameter - DS1390Publisher object
+// Returns:     none
+
+void DS1390Publisher::task (void *Parameter)
+{
+  DS1390Publisher *Publisher = (DS1390Publisher *)Parameter;
+  TickType_t LastWake = xTaskGetTickCount ();
+
+  for (;;)
+  {
+    vTaskDelayUntil (&LastWake, pdMS_TO_TICKS(Publisher->_PeriodMs));
+    Publisher->refresh ();
+  }
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+#endif
+
+// Name:        refresh
+// Description: Reads the RTC and publishes the result - Call from a single task only
+// Arguments:   none
+// Returns:     none
+
+void DS1390Publisher::refresh ()
+{
+  // Read RTC outside the critical section
+  DS1390DateTime DateTime;
+  _Clock.getDateTimeSnapshot (DateTime);
+  const uint32_t Millis = millis ();
+  uint16_t Milliseconds;
+  const uint32_t Epoch = _Clock.dateTimeToTrimmedEpoch (DateTime, _Timezone, &Milliseconds);
+
+  // Odd sequence - Readers retry
+  _Sequence = _Sequence + 1;
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+  // Publish
+  _DateTime = DateTime;
+  _Epoch = Epoch;
+  _Milliseconds = Milliseconds;
+  _PublishMillis = Millis;
+
+  // Even sequence - Data is consistent again
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  _Sequence = _Sequence + 1;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        read
+// Description: Gets a consistent copy of the last published time without locks or SPI access
+// Arguments:   DateTime - DS1390DateTime structure to store the data (RTC registers as read)
+//              Epoch - Optional pointer to store the epoch timestamp (with the software trim
+//              applied, like getDateTimeEpoch)
+// Returns:     false if nothing was published yet or no consistent copy was got in
+//              DS1390_PUBLISHER_RETRIES attempts, true on completion
+
+bool DS1390Publisher::read (DS1390DateTime &DateTime, uint32_t *Epoch) const
+{
+  uint32_t Start;
+  uint32_t Value;
+  uint8_t Retry = 0;
+
+  for (;;)
+  {
+    Start = _Sequence;
+
+    // Refresh in progress - Let it finish
+    if (Start & 1)
+      waitRefresh ();
+
+    else
+    {
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+      // Copy
+      DateTime = _DateTime;
+      Value = _Epoch;
+
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+      // Copy did not overlap a refresh
+      if (_Sequence == Start)
+        break;
+    }
+
+    // Refresher preempted by this reader - Give up
+    if (++Retry >= DS1390_PUBLISHER_RETRIES)
+      return false;
+  }
+
+  // Epoch
+  if (Epoch != nullptr)
+    *Epoch = Value;
+
+  // Nothing published yet
+  return Start != 0;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getEpoch
+// Description: Gets the last published time advanced by the time elapsed since it was read,
+//              without locks or SPI access
+// Arguments:   Milliseconds - Optional pointer to store the milliseconds (0 to 999)
+// Returns:     Epoch timestamp - 0 if nothing was published yet or no consistent copy was got
+//              in DS1390_PUBLISHER_RETRIES attempts
+
+uint32_t DS1390Publisher::getEpoch (uint16_t *Milliseconds) const
+{
+  uint32_t Start;
+  uint32_t Epoch;
+  uint32_t Total;
+  uint8_t Retry = 0;
+
+  for (;;)
+  {
+    Start = _Sequence;
+
+    // Refresh in progress - Let it finish
+    if (Start & 1)
+      waitRefresh ();
+
+    else
+    {
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+      // Copy
+      Epoch = _Epoch;
+      Total = _Milliseconds + (millis () - _PublishMillis);
+
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+      // Copy did not overlap a refresh
+      if (_Sequence == Start)
+        break;
+    }
+
+    // Refresher preempted by this reader - Give up
+    if (++Retry >= DS1390_PUBLISHER_RETRIES)
+      return 0;
+  }
+
+  // Nothing published yet
+  if (Start == 0)
+    return 0;
+
+  // Milliseconds
+  if (Milliseconds != nullptr)
+    *Milliseconds = Total % 1000;
+
+  // Return epoch
+  return Epoch + Total / 1000;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getGeneration
+// Description: Gets the number of refreshes published so far
+// Arguments:   none
+// Returns:     Number of refreshes
+
+uint32_t DS1390Publisher::getGeneration () const
+{
+  return _Sequence / 2;
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
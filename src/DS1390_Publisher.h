@@ -0,0 +1,92 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Publisher - Lock-free shared RTC time for multi-task readers
+//
+// Notes:   - One refresher owns the SPI bus and publishes the RTC time with refresh()
+//          - Any number of readers get a consistent copy with read() or getEpoch(), without
+//            locks or SPI access. The copy is protected by a sequence lock (seqlock)
+//          - On ESP32, begin() starts a FreeRTOS task that calls refresh() periodically
+//          - On AVR, call refresh() from loop() only (not from interrupts)
+//          - Readers give up after DS1390_PUBLISHER_RETRIES attempts, so a reader that preempted
+//            the refresher mid-publish (interrupt or higher priority task) fails instead of
+//            spinning forever. On ESP32, reader tasks block for one tick between attempts
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_Publisher_h
+#define DS1390_Publisher_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SPI.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Refresher task settings (ESP32)
+#define DS1390_PUBLISHER_STACK      2048
+#define DS1390_PUBLISHER_PRIORITY   2
+
+// Reader attempts before read() and getEpoch() give up
+#ifndef DS1390_PUBLISHER_RETRIES
+#define DS1390_PUBLISHER_RETRIES    8
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Publisher class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390Publisher
+{
+  public:
+    // Constructor
+    DS1390Publisher (DS1390 &Clock, DS1390Timezone Timezone = 0)
+      : _Clock(Clock),        // Save RTC object
+        _Timezone(Timezone)   // Save timezone of published epoch
+    {}
+
+#if defined(ESP32)
+    // Starts the refresher task
+    bool begin (uint16_t PeriodMs);
+#endif
+
+    // Refresher side - Reads the RTC and publishes the result
+    void refresh ();
+
+    // Reader side - Lock-free
+    bool read (DS1390DateTime &DateTime, uint32_t *Epoch = nullptr) const;
+    uint32_t getEpoch (uint16_t *Milliseconds = nullptr) const;
+    uint32_t getGeneration () const;
+
+  private:
+    // RTC object
+    DS1390 &_Clock;
+
+    // Timezone of published epoch
+    const DS1390Timezone _Timezone;
+
+    // Sequence counter - Odd while a refresh is in progress, incremented twice per refresh
+    volatile uint32_t _Sequence = 0;
+
+    // Published data
+    DS1390DateTime _DateTime;
+    uint32_t _Epoch = 0;
+    uint16_t _Milliseconds = 0;
+    uint32_t _PublishMillis = 0;
+
+#if defined(ESP32)
+    // Refresher task
+    uint16_t _PeriodMs = 0;
+    static void task (void *Parameter);
+#endif
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -6,9 +6,14 @@
 // Date:    October 19, 2019
 //
 // Notes:   - A 200ms (min) delay is required after boot. It done inside the constructor
+//          - begin(true, true) skips that delay on warm starts using a boot marker stored in
+//            the control register (DS1390 only - It is the real control register in the DS1391)
 //          - Hundredths of Seconds register is ignored in Epoch related functions
 //          - Works with DS1391 aswell.
 //          - Alarm-related functions not implemented yet
+//          - Concurrency: all date and time buffers are local, so epoch conversions are
+//            reentrant once the time format is cached. Calls that access the SPI bus are not
+//            locked - Serialize them in the application or use a single DS1390Publisher
 //
 // Knwon bugs:  - In 12h format, the device do not change the AM/PM bit neither increments
 //              the day of the week and day counters. Everything works in 24h mode
@@ -38,6 +43,23 @@
 // Duration of months of the year
 static const uint8_t _MonthDuration[] PROGMEM = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
+#if DS1390_ENABLE_YEAR_TABLE
+// Epoch of Jan 1 00:00:00 GMT for each year from DS1390_YEAR_TABLE_BASE, with the leap year flag
+// in bit 0 (midnight epochs are even). Years past 2106 do not fit 32 bits and hold 0xFFFFFFFF
+#define DS1390_YT_ENTRY(Y)  (((Y) > 2106) ? 0xFFFFFFFFUL : \
+  ((365UL * ((Y) - 1970) + ((Y) - 1) / 4 - ((Y) - 1) / 100 + ((Y) - 1) / 400 - 477) * 86400UL) \
+  | ((((Y) % 4) == 0) && ((((Y) % 100) != 0) || (((Y) % 400) == 0))))
+#define DS1390_YT_2(Y)      DS1390_YT_ENTRY(Y), DS1390_YT_ENTRY((Y) + 1)
+#define DS1390_YT_4(Y)      DS1390_YT_2(Y), DS1390_YT_2((Y) + 2)
+#define DS1390_YT_8(Y)      DS1390_YT_4(Y), DS1390_YT_4((Y) + 4)
+#define DS1390_YT_16(Y)     DS1390_YT_8(Y), DS1390_YT_8((Y) + 8)
+#define DS1390_YT_32(Y)     DS1390_YT_16(Y), DS1390_YT_16((Y) + 16)
+#define DS1390_YT_64(Y)     DS1390_YT_32(Y), DS1390_YT_32((Y) + 32)
+#define DS1390_YT_128(Y)    DS1390_YT_64(Y), DS1390_YT_64((Y) + 64)
+
+static const uint32_t _YearStart[DS1390_YEAR_TABLE_SIZE] PROGMEM = {DS1390_YT_128(DS1390_YEAR_TABLE_BASE)};
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 // Functions definitions
 /* ------------------------------------------------------------------------------------------- */
@@ -45,9 +67,13 @@ static const uint8_t _MonthDuration[] PROGMEM = {31, 28, 31, 30, 31, 30, 31, 31,
 // Name:        begin
 // Description: Initializes hardware
 // Arguments:   Wait - disabling it allows user to use a different method
+//              FastBoot - Enables the boot marker in the control register (DS1390 only). If
+//              the marker is found and the oscillator never stopped, the device was powered
+//              during the reset, so the powerup delay is skipped and the format, validation
+//              and trim caches are primed from a single burst read
 // Returns:     none
 
-void DS1390::begin (bool Wait)
+void DS1390::begin (bool Wait, bool FastBoot)
 {
   // Set chip select pin as output
   pinMode (_PinCs, OUTPUT);
@@ -55,12 +81,148 @@ void DS1390::begin (bool Wait)
   // Deselect device (active low)
   digitalWrite (_PinCs, HIGH);
 
+  // Format, validation, trim and trim anchor are read again on first use
+  _Format = DS1390_FORMAT_UNKNOWN;
+  _Validated = false;
+  _Trim = DS1390_TRIM_UNKNOWN;
+  _TrimAnchor = DS1390_ANCHOR_UNKNOWN;
+
+  // Start SPI bus
+  if (_SoftSpi != nullptr)
+    _SoftSpi->begin ();
+  else
+    SPI.begin ();
+
+  // Warm start check - A device still powering up does not answer with the marker
+  if (FastBoot)
+  {
+    // Control (SRAM), Status and Trickle charger registers
+    uint8_t Registers[3];
+    readBurst (DS1390_ADDR_READ_CFG, Registers, 3);
+
+    // Marker found and oscillator never stopped - Prime caches and skip delay
+    if (((Registers[0] & DS1390_SRAM_TAG_MASK) == DS1390_SRAM_TAG) && ((Registers[1] & DS1390_MASK_OSF) == 0))
+    {
+      _Validated = true;
+      _Format = (Registers[0] & DS1390_SRAM_FORMAT) >> 5;
+      _Trim = (int8_t)((Registers[0] & DS1390_SRAM_TRIM_MASK) << 3) >> 3;
+      _Sram = Registers[0];
+      return;
+    }
+  }
+
   // A 200ms powerup delay is mandatory for DS1391
   if (Wait)
     delay (200);
 
-  // Start SPI bus
-  SPI.begin ();
+  // Write marker for the next boot - Keeps stored trim
+  if (FastBoot)
+  {
+    const uint8_t Sram = DS1390_SRAM_TAG | (getTimeFormat () << 5) | (getTrim () & DS1390_SRAM_TRIM_MASK);
+    writeByte (DS1390_ADDR_WRITE_CFG, Sram);
+    _Sram = Sram;
+  }
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getClock
+// Description: Gets the SPI clock used by this instance
+// Arguments:   None
+// Returns:     SPI clock (Hz)
+
+uint32_t DS1390::getClock () const
+{
+  return _Clock;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        setClock
+// Description: Sets the SPI clock used by this instance - The transaction settings are built
+//              here once instead of in every transfer
+// Arguments:   Clock - SPI clock (Hz). The SPI library rounds it down to a supported value.
+//              No effect on a software SPI bus
+// Returns:     None
+
+void DS1390::setClock (uint32_t Clock)
+{
+  _Clock = Clock;
+  _SpiSettings = SPISettings(Clock, MSBFIRST, SPI_MODE1);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        probeClock
+// Description: Finds the highest reliable SPI clock for the current wiring. The clock is doubled
+//              from DS1390_PROBE_MIN_CLOCK up to MaxClock and test patterns are written to and
+//              read back from the control register at each step. The step below the highest
+//              passing one is kept as margin (the highest one if no step fails or if it is the
+//              only one).
+//              A failing step may corrupt the address byte and write to another register. Alarm,
+//              control, status and trickle charger registers are saved at the previous clock and
+//              rewritten at that clock afterwards. No pattern is a valid trickle charger code
+//              (upper nibble 1010), so a stray write disables the charger until then instead of
+//              enabling it. A cleared oscillator stop flag cannot be set back, and time registers
+//              are not restored, so probe before setting date and time.
+//              DS1390 only - The control register is used as SRAM. In the DS1391, the patterns
+//              would stop the oscillator
+// Arguments:   MaxClock - Highest clock to be tried (Hz)
+// Returns:     Selected clock (Hz) or 0 if DS1390_PROBE_MIN_CLOCK already fails (the previous
+//              clock is kept in that case)
+
+uint32_t DS1390::probeClock (uint32_t MaxClock)
+{
+  // Test patterns - Alternating, solid and mixed bits. None has 1010 in the upper nibble
+  static const uint8_t Patterns[DS1390_PROBE_PATTERNS] PROGMEM = {0x55, 0x5A, 0x00, 0xFF, 0x0F, 0xF0, 0x69, 0x96};
+
+  // Save alarm, control, status and trickle charger registers at the current clock
+  const uint32_t Previous = _Clock;
+  uint8_t Saved[DS1390_ADDR_READ_TCH - DS1390_ADDR_READ_AHSEC + 1];
+  readBurst (DS1390_ADDR_READ_AHSEC, Saved, sizeof(Saved));
+
+  // Highest passing step and the one below it
+  uint32_t Passed = 0;
+  uint32_t Reliable = 0;
+  bool Failed = false;
+
+  // Step up the clock until a readback fails
+  for (uint32_t Clock = DS1390_PROBE_MIN_CLOCK; (Clock <= MaxClock) && !Failed; Clock *= 2)
+  {
+    setClock (Clock);
+
+    for (uint8_t Counter = 0; Counter < DS1390_PROBE_PATTERNS; Counter++)
+    {
+      const uint8_t Pattern = pgm_read_byte(&Patterns[Counter]);
+      writeByte (DS1390_ADDR_WRITE_CFG, Pattern);
+
+      if (readByte (DS1390_ADDR_READ_CFG) != Pattern)
+      {
+        Failed = true;
+        break;
+      }
+    }
+
+    if (!Failed)
+    {
+      Reliable = Passed;
+      Passed = Clock;
+    }
+  }
+
+  // Keep margin only if a limit was found and there is a lower passing step
+  const uint32_t Selected = (Failed && (Reliable != 0)) ? Reliable : Passed;
+
+  // Restore registers at the known good clock
+  setClock (Previous);
+  writeBurst (DS1390_ADDR_WRITE_AHSEC, Saved, sizeof(Saved));
+
+  // Select clock - Previous clock if nothing is reliable
+  if (Selected != 0)
+    setClock (Selected);
+
+  // Return selected clock
+  return Selected;
 }
 
 /* ------------------------------------------------------------------------------------------- */
@@ -89,6 +251,55 @@ uint8_t DS1390::bcd2dec (uint8_t BCDValue)
 
 /* ------------------------------------------------------------------------------------------- */
 
+// Name:        beginTransfer
+// Description: Begins a transaction on the selected bus and selects the device
+// Arguments:   None
+// Returns:     none
+
+void DS1390::beginTransfer ()
+{
+  // Configure SPI transaction - Hardware bus only
+  if (_SoftSpi == nullptr)
+    SPI.beginTransaction(_SpiSettings);
+
+  // Select device (active low)
+  digitalWrite (_PinCs, LOW);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        transfer
+// Description: Sends and receives a byte on the selected bus
+// Arguments:   Data - Byte to be sent
+// Returns:     Byte received
+
+uint8_t DS1390::transfer (uint8_t Data)
+{
+  if (_SoftSpi != nullptr)
+    return _SoftSpi->transfer (Data);
+
+  return SPI.transfer (Data);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        endTransfer
+// Description: Deselects the device and ends the transaction on the selected bus
+// Arguments:   None
+// Returns:     none
+
+void DS1390::endTransfer ()
+{
+  // Deselect device (active low)
+  digitalWrite (_PinCs, HIGH);
+
+  // End SPI transaction - Hardware bus only
+  if (_SoftSpi == nullptr)
+    SPI.endTransaction ();
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
 // Name:        writeByte
 // Description: Writes a byte to DS1390 memory
 // Arguments:   Address - Register to be written
@@ -97,23 +308,17 @@ uint8_t DS1390::bcd2dec (uint8_t BCDValue)
 
 void DS1390::writeByte(uint8_t Address, uint8_t Data)
 {
-  // Configure SPI transaction
-  SPI.beginTransaction(SPISettings(DS1390_SPI_CLOCK, MSBFIRST, SPI_MODE1));
-
-  // Select device (active low)
-  digitalWrite (_PinCs, LOW);
+  // Begin transaction and select device
+  beginTransfer ();
 
   // Send address byte
-  SPI.transfer (Address);
+  transfer (Address);
 
   // Send data byte
-  SPI.transfer (Data);
+  transfer (Data);
 
-  // Deselect device (active low)
-  digitalWrite (_PinCs, HIGH);
-
-  // End SPI transaction
-  SPI.endTransaction ();
+  // Deselect device and end transaction
+  endTransfer ();
 }
 
 /* ------------------------------------------------------------------------------------------- */
@@ -128,23 +333,17 @@ uint8_t DS1390::readByte (uint8_t Address)
   // Data byte
   uint8_t Data = 0;
 
-  // Configure SPI transaction
-  SPI.beginTransaction(SPISettings(DS1390_SPI_CLOCK, MSBFIRST, SPI_MODE1));
-
-  // Select device (active low)
-  digitalWrite (_PinCs, LOW);
+  // Begin transaction and select device
+  beginTransfer ();
 
   // Send address byte
-  SPI.transfer (Address);
+  transfer (Address);
 
   // Read data byte (0xFF = dummy)
-  Data = SPI.transfer (0xFF);
+  Data = transfer (0xFF);
 
-  // Deselect device (active low)
-  digitalWrite (_PinCs, HIGH);
-
-  // End SPI transaction
-  SPI.endTransaction();
+  // Deselect device and end transaction
+  endTransfer ();
 
   // Return read byte
   return Data;
@@ -152,13 +351,102 @@ uint8_t DS1390::readByte (uint8_t Address)
 
 /* ------------------------------------------------------------------------------------------- */
 
+// Name:        readBurst
+// Description: Reads consecutive bytes from DS1390 memory in a single transaction
+// Arguments:   Address - First register to be read
+//              Data - Buffer to store the bytes read
+//              Length - Number of bytes to be read
+// Returns:     none
+
+void DS1390::readBurst (uint8_t Address, uint8_t *Data, uint8_t Length)
+{
+  // Begin transaction and select device
+  beginTransfer ();
+
+  // Send first address byte
+  transfer (Address);
+
+  // Read data bytes sequentially (0xFF = dummy)
+  for (uint8_t Counter = 0; Counter < Length; Counter++)
+    Data[Counter] = transfer (0xFF);
+
+  // Deselect device and end transaction
+  endTransfer ();
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        writeBurst
+// Description: Writes consecutive bytes to DS1390 memory in a single transaction
+// Arguments:   Address - First register to be written
+//              Data - Bytes to be written
+//              Length - Number of bytes to be written
+// Returns:     none
+
+void DS1390::writeBurst (uint8_t Address, const uint8_t *Data, uint8_t Length)
+{
+  // Begin transaction and select device
+  beginTransfer ();
+
+  // Send first address byte
+  transfer (Address);
+
+  // Write data bytes sequentially
+  for (uint8_t Counter = 0; Counter < Length; Counter++)
+    transfer (Data[Counter]);
+
+  // Deselect device and end transaction
+  endTransfer ();
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+#if DS1390_ENABLE_EPOCH
+
+// Name:        yearStart
+// Description: Gets the epoch of Jan 1 00:00:00 GMT of a year - Read from the year start table
+//              if it is enabled and covers the year
+// Arguments:   Year - Year (1970 to 2106)
+// Returns:     Epoch timestamp
+
+uint32_t DS1390::yearStart (uint16_t Year)
+{
+#if DS1390_ENABLE_YEAR_TABLE
+  // Table lookup
+  if ((Year >= DS1390_YEAR_TABLE_BASE) && ((Year - DS1390_YEAR_TABLE_BASE) < DS1390_YEAR_TABLE_SIZE))
+  {
+    const uint32_t Entry = pgm_read_dword(&_YearStart[Year - DS1390_YEAR_TABLE_BASE]);
+
+    if (Entry != 0xFFFFFFFFUL)
+      return Entry & ~1UL;
+  }
+#endif
+
+  // Epoch time starts in 1970
+  const uint16_t EpochYear = Year - 1970;
+
+  // 31536000 seconds per year
+  uint32_t Epoch = EpochYear * (86400UL * 365);
+
+  // Add extra days for leap years
+  for (uint16_t Counter = 0; Counter < EpochYear; Counter++)
+  {
+    if (LEAP_YEAR(Counter))
+      Epoch += 86400;
+  }
+
+  return Epoch;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
 // Name:        dateTimeToEpoch
 // Description: Converts DS1390DateTime structure to Epoch timestamp - Ignores hundredths of sec.
 // Arguments:   DateTime - DS1390DateTime structure with the data
-//              Timezone - Timezone info (-12 to +12, 0 = GMT) of DateTime
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of DateTime
 // Returns:     Epoch timestamp referred to Timezone
 
-uint32_t DS1390::dateTimeToEpoch (DS1390DateTime &DateTime, int Timezone)
+uint32_t DS1390::dateTimeToEpoch (const DS1390DateTime &DateTime, DS1390Timezone Timezone)
 {
   // Seconds since 00:00:00 - Jan 1, 1970 GMT
   uint32_t Epoch = 0;
@@ -169,26 +457,14 @@ uint32_t DS1390::dateTimeToEpoch (DS1390DateTime &DateTime, int Timezone)
   // Epoch time starts in 1970
   uint16_t EpochYear = DateTime.Year - 1970;
 
-  // 12h mode
-  if ((getTimeFormat() == DS1390_FORMAT_12H) && (DateTime.AmPm == DS1390_PM))
-    DateTime.Hour += 12;
+  // Hours in 24h format
+  const uint8_t Hour = hourTo24h (DateTime);
 
-  // Correct value for given timezone
-  if (Timezone != 0)
-  {
-    long Correction = (constrain(Timezone, -12, 12) * -3600);
-    Epoch += Correction;
-  }
+  // Correct value for given timezone - Offset already validated
+  Epoch -= Timezone.Seconds;
 
   // Seconds from 1970 until 1 jan 00:00:00 of the given year
-  Epoch += EpochYear * (86400 * 365); // 31536000 seconds per year
-
-  // Add extra days for leap years
-  for (Counter = 0; Counter < EpochYear; Counter++)
-  {
-    if (LEAP_YEAR(Counter))
-      Epoch += 86400;
-  }
+  Epoch += yearStart (DateTime.Year);
 
   // Add days for given year - Months start from 1
   for (Counter = 1; Counter < DateTime.Month; Counter++)
@@ -203,7 +479,7 @@ uint32_t DS1390::dateTimeToEpoch (DS1390DateTime &DateTime, int Timezone)
 
   // Add days for given month
   Epoch += (DateTime.Day - 1) * 86400; // 86400 seconds per day
-  Epoch += DateTime.Hour * 3600; // 3600 seconds per hour
+  Epoch += Hour * 3600UL; // 3600 seconds per hour
   Epoch += DateTime.Minute * 60; // 60 seconds per minute
   Epoch += DateTime.Second;
 
@@ -217,21 +493,18 @@ uint32_t DS1390::dateTimeToEpoch (DS1390DateTime &DateTime, int Timezone)
 // Description: Converts Epoch timestamp to DS1390DateTime structure - Ignores hundredths of sec.
 // Arguments:   Epoch - Epoch timestamp
 //              DateTime - DS1390DateTime structure to store the data
-//              Timezone - Timezone info (-12 to +12, 0 = GMT) of Epoch
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of Epoch
 // Returns:     None
 
-void DS1390::epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, int Timezone)
+void DS1390::epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, DS1390Timezone Timezone)
 {
-  // Variables
-  uint32_t EpochTime = Epoch;
+  // Variables - Corrected for given timezone (offset already validated)
+  uint32_t EpochTime = Epoch + Timezone.Seconds;
   uint8_t Year = 0;
   uint8_t Month = 0;
   uint8_t MonthLength = 0;
   uint32_t Days = 0;
-
-  // Correct value for given timezone
-  if (Timezone != 0)
-    EpochTime += (Timezone * 3600);
+  bool Leap = false;
 
   // Calculate seconds
   DateTime.Second = EpochTime % 60;
@@ -245,57 +518,57 @@ void DS1390::epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, int Time
   // Get remaining time in hours
   EpochTime /= 60;
 
-  // Calculate hours
-  DateTime.Hour = EpochTime % 24;
+  // Calculate hours - Converted to 12h format if needed
+  hourFrom24h (EpochTime % 24, DateTime);
 
-  // 12h format
-  if (getTimeFormat() == DS1390_FORMAT_12H)
-  {
-    // 0 = 12AM
-    if (DateTime.Hour == 0)
-    {
-      DateTime.Hour = 12;
-      DateTime.AmPm = DS1390_AM;
-    }
+  // Get remaining time in days
+  EpochTime /= 24;
 
-    // 12 = 12PM
-    else if (DateTime.Hour == 12)
-    {
-      DateTime.Hour = 12;
-      DateTime.AmPm = DS1390_PM;
-    }
+  // Get weekday
+  DateTime.Wday = ((EpochTime + 4) % 7) + 1;  // Sunday is day 1
 
-    // 1-11 = 1-11AM
-    else if (DateTime.Hour < 12)
-    {
-      DateTime.AmPm = DS1390_AM;
-    }
+#if DS1390_ENABLE_YEAR_TABLE
+  // Binary search in the year start table - Table range only
+  const uint32_t DayStart = EpochTime * 86400;
+  uint8_t Low = 0;
+  uint8_t High = DS1390_YEAR_TABLE_SIZE - 1;
 
-    // 13-23 = 1-11 PM
-    else
+  if ((DayStart >= pgm_read_dword(&_YearStart[Low])) && (DayStart < (pgm_read_dword(&_YearStart[High]) & ~1UL)))
+  {
+    // Last entry not above DayStart
+    while ((High - Low) > 1)
     {
-      DateTime.Hour -= 12;
-      DateTime.AmPm = DS1390_PM;
-    }
-  }
+      const uint8_t Middle = (Low + High) / 2;
 
-  // Get remaining time in days
-  EpochTime /= 24;
+      if ((pgm_read_dword(&_YearStart[Middle]) & ~1UL) <= DayStart)
+        Low = Middle;
+      else
+        High = Middle;
+    }
 
-  // Get weekday
-  DateTime.Wday = ((EpochTime + 4) % 7) + 1;  // Sunday is day 1
+    // Get year, leap flag and remaining time in days since Jan 1 of the given year
+    const uint32_t Entry = pgm_read_dword(&_YearStart[Low]);
+    DateTime.Year = DS1390_YEAR_TABLE_BASE + Low;
+    Leap = Entry & 1;
+    EpochTime -= (Entry & ~1UL) / 86400;
+  }
 
-  // Calculate years since 1970
-  while((unsigned)(Days += (LEAP_YEAR(Year) ? 366 : 365)) <= EpochTime)
-    Year++;
+  else
+#endif
+  {
+    // Calculate years since 1970
+    while((unsigned)(Days += (LEAP_YEAR(Year) ? 366 : 365)) <= EpochTime)
+      Year++;
 
-  // Get absolute value
-  DateTime.Year = Year - 30;
+    // Get absolute value
+    DateTime.Year = 1970 + Year;
+    Leap = LEAP_YEAR(Year);
 
-  Days -= LEAP_YEAR(Year) ? 366 : 365;
+    Days -= Leap ? 366 : 365;
 
-  // Get remaining time in days since Jan 1 of the given year
-  EpochTime -= Days;
+    // Get remaining time in days since Jan 1 of the given year
+    EpochTime -= Days;
+  }
 
   // Calculate month duration
   for (Month = 0; Month < 12; Month++)
@@ -303,7 +576,7 @@ void DS1390::epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, int Time
     // February
     if (Month == 1)
     {
-      if (LEAP_YEAR(Year))
+      if (Leap)
         MonthLength = 29;
 
       else
@@ -327,46 +600,202 @@ void DS1390::epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, int Time
   DateTime.Day = EpochTime + 1;
 }
 
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        packDateTime
+// Description: Packs a DS1390DateTime structure into a 32-bit timestamp - Ignores hundredths
+//              of sec. and week day. Years outside YearBase to YearBase + 63 are constrained
+// Arguments:   DateTime - DS1390DateTime structure with the data
+// Returns:     Packed timestamp
+
+DS1390Packed DS1390::packDateTime (const DS1390DateTime &DateTime)
+{
+  // Hours are always packed in 24h format
+  const uint8_t Hour = hourTo24h (DateTime);
+
+  // Year offset from YearBase
+  uint16_t YearOffset = (DateTime.Year > _YearBase) ? (DateTime.Year - _YearBase) : 0;
+
+  // Assemble fields - Constrain values within allowed limits
+  return ((DS1390Packed)constrain(YearOffset, 0, DS1390_PACKED_YRS_MAX) << DS1390_PACKED_YRS_POS)
+         | ((DS1390Packed)constrain(DateTime.Month, 1, 12) << DS1390_PACKED_MON_POS)
+         | ((DS1390Packed)constrain(DateTime.Day, 1, 31) << DS1390_PACKED_DAY_POS)
+         | ((DS1390Packed)constrain(Hour, 0, 23) << DS1390_PACKED_HRS_POS)
+         | ((DS1390Packed)constrain(DateTime.Minute, 0, 59) << DS1390_PACKED_MIN_POS)
+         | ((DS1390Packed)constrain(DateTime.Second, 0, 59) << DS1390_PACKED_SEC_POS);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        unpackDateTime
+// Description: Unpacks a 32-bit timestamp into a DS1390DateTime structure
+// Arguments:   Packed - Packed timestamp
+//              DateTime - DS1390DateTime structure to store the data
+// Returns:     None
+
+void DS1390::unpackDateTime (DS1390Packed Packed, DS1390DateTime &DateTime)
+{
+  // Extract fields
+  DateTime.Hsecond = 0;
+  DateTime.Second = (Packed >> DS1390_PACKED_SEC_POS) & 0x3F;
+  DateTime.Minute = (Packed >> DS1390_PACKED_MIN_POS) & 0x3F;
+  DateTime.Day = (Packed >> DS1390_PACKED_DAY_POS) & 0x1F;
+  DateTime.Month = (Packed >> DS1390_PACKED_MON_POS) & 0x0F;
+  DateTime.Year = _YearBase + (Packed >> DS1390_PACKED_YRS_POS);
+  DateTime.Wday = weekDayFromDate (DateTime);
+
+  // Hours are packed in 24h format - Converted to 12h format if needed
+  hourFrom24h ((Packed >> DS1390_PACKED_HRS_POS) & 0x1F, DateTime);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        packRegisters
+// Description: Packs a raw image of the date and time registers (0x00 to 0x07) into a 32-bit
+//              timestamp without going through a DS1390DateTime structure
+// Arguments:   Registers - 8 bytes in DS1390 BCD format, Hundredths of Seconds first
+// Returns:     Packed timestamp
+
+DS1390Packed DS1390::packRegisters (const uint8_t *Registers) const
+{
+  // Hours register
+  uint8_t Hour = Registers[DS1390_ADDR_READ_HRS];
+
+  // Convert hours - 24h format
+  if ((Hour & DS1390_MASK_FORMAT) == 0)
+    Hour = bcd2dec(Hour & 0x3F);
+
+  // Convert hours - 12h format
+  else
+    Hour = (bcd2dec(Hour & 0x1F) % 12) + ((Hour & DS1390_MASK_AMPM) ? 12 : 0);
+
+  // Year offset - Century bit adds 100 years to YearBase
+  uint8_t YearOffset = bcd2dec(Registers[DS1390_ADDR_READ_YRS])
+                       + ((Registers[DS1390_ADDR_READ_MON] & DS1390_MASK_CENTURY) ? 100 : 0);
+
+  // Constrain to the packed range
+  if (YearOffset > DS1390_PACKED_YRS_MAX)
+    YearOffset = DS1390_PACKED_YRS_MAX;
+
+  // Assemble fields
+  return ((DS1390Packed)YearOffset << DS1390_PACKED_YRS_POS)
+         | ((DS1390Packed)bcd2dec(Registers[DS1390_ADDR_READ_MON] & 0x1F) << DS1390_PACKED_MON_POS)
+         | ((DS1390Packed)bcd2dec(Registers[DS1390_ADDR_READ_DAY]) << DS1390_PACKED_DAY_POS)
+         | ((DS1390Packed)Hour << DS1390_PACKED_HRS_POS)
+         | ((DS1390Packed)bcd2dec(Registers[DS1390_ADDR_READ_MIN]) << DS1390_PACKED_MIN_POS)
+         | ((DS1390Packed)bcd2dec(Registers[DS1390_ADDR_READ_SEC]) << DS1390_PACKED_SEC_POS);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        unpackRegisters
+// Description: Unpacks a 32-bit timestamp into a raw image of the date and time registers
+//              (0x00 to 0x07) using the current time format. Hundredths of sec. are set to 0
+// Arguments:   Packed - Packed timestamp
+//              Registers - 8 bytes to store the data in DS1390 BCD format
+// Returns:     None
+
+void DS1390::unpackRegisters (DS1390Packed Packed, uint8_t *Registers)
+{
+  // Get fields and week day
+  DS1390DateTime DateTime;
+  unpackDateTime (Packed, DateTime);
+
+  // Convert fields
+  Registers[DS1390_ADDR_READ_HSEC] = 0;
+  Registers[DS1390_ADDR_READ_SEC] = dec2bcd(DateTime.Second);
+  Registers[DS1390_ADDR_READ_MIN] = dec2bcd(DateTime.Minute);
+  Registers[DS1390_ADDR_READ_WDAY] = dec2bcd(DateTime.Wday);
+  Registers[DS1390_ADDR_READ_DAY] = dec2bcd(DateTime.Day);
+  Registers[DS1390_ADDR_READ_MON] = dec2bcd(DateTime.Month);
+  Registers[DS1390_ADDR_READ_YRS] = dec2bcd(Packed >> DS1390_PACKED_YRS_POS);
+
+  // 24h mode
+  if (!DS1390_IS_12H (*this))
+    Registers[DS1390_ADDR_READ_HRS] = dec2bcd(DateTime.Hour);
+
+  // 12h mode - Store AmPm info in AmPm bit of Hour register and set format bit
+  else
+    Registers[DS1390_ADDR_READ_HRS] = dec2bcd(DateTime.Hour) | (DateTime.AmPm << 5) | DS1390_MASK_FORMAT;
+}
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getValidation
-// Description: Gets the OSF bit from DS1390 memory
+// Description: Gets the OSF bit from DS1390 memory and updates the cached OSF state
 // Arguments:   None
 // Returns:     false if memory content was recently lost or true otherwise
 
 bool DS1390::getValidation ()
 {
+  // OSF bit is cleared when it reads as 0
+  _Validated = ((readByte(DS1390_ADDR_READ_STS) & DS1390_MASK_OSF) == 0);
+
   // Return validation flag
-  if (((readByte(DS1390_ADDR_READ_STS) & DS1390_MASK_OSF) >> 7) == 1)
-    return false;
-  else
-    return true;
+  return _Validated;
 }
 
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        setValidation
-// Description: Resets the OSF bit in DS1390 memory
+// Description: Resets the OSF bit in DS1390 memory - Skipped if it is already known to be cleared
 // Arguments:   None
 // Returns:     None
 
 void DS1390::setValidation ()
 {
+  // OSF already cleared since boot (or since last getValidation/revalidate)
+  if (_Validated)
+    return;
+
   // Send value to DS1390
   writeByte (DS1390_ADDR_WRITE_STS, readByte(DS1390_ADDR_READ_STS) & ~DS1390_MASK_OSF);
+
+  // Remember OSF state
+  _Validated = true;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        revalidate
+// Description: Discards the cached OSF state and resets the OSF bit in DS1390 memory. Call it
+//              if the oscillator may have stopped since the last access (e.g. RTC power loss)
+// Arguments:   None
+// Returns:     None
+
+void DS1390::revalidate ()
+{
+  // Forget cached state
+  _Validated = false;
+
+  // Reset OSF bit
+  setValidation ();
 }
 
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getTimeFormat
-// Description: Gets the current time format (12h/24h) from DS1390 memory
+// Description: Gets the current time format (12h/24h) - DS1390 memory is read only once, later
+//              calls return the cached value
 // Arguments:   None
-// Returns:     DS1390_FORMAT_24H (logic 0) or DS1390_FORMAT_12H (logic 1)
+// Returns:     DS1390_FORMAT_24H (logic 0) or DS1390_FORMAT_12H (logic 1) - Always
+//              DS1390_TIME_FORMAT if it is not DS1390_FORMAT_RUNTIME
 
 uint8_t DS1390::getTimeFormat ()
 {
-  // Return format bit of Hours register
-  return ((readByte (DS1390_ADDR_READ_HRS) & DS1390_MASK_FORMAT) >> 6);
+#if DS1390_TIME_FORMAT == DS1390_FORMAT_RUNTIME
+  // Read format bit of Hours register if not cached yet
+  if (_Format == DS1390_FORMAT_UNKNOWN)
+    _Format = ((readByte (DS1390_ADDR_READ_HRS) & DS1390_MASK_FORMAT) >> 6);
+
+  // Return cached format
+  return _Format;
+#else
+  // Format fixed at compile time - No read
+  return DS1390_TIME_FORMAT;
+#endif
 }
 
 /* ------------------------------------------------------------------------------------------- */
@@ -374,21 +803,31 @@ uint8_t DS1390::getTimeFormat ()
 // Name:        setTimeFormat
 // Description: Sets the time format (12h/24h) on DS1390 memory
 // Arguments:   DS1390_FORMAT_24H (logic 0) or DS1390_FORMAT_12H (logic 1)
-// Returns:     false if new format is equal to current or true on completion
+// Returns:     false if new format is equal to current or differs from a fixed
+//              DS1390_TIME_FORMAT or true on completion
 
 bool DS1390::setTimeFormat (uint8_t Format)
 {
   // Current value stored on Hours register
   uint8_t HrsReg = readByte(DS1390_ADDR_READ_HRS);
 
+  // Refresh cached format
+  _Format = ((HrsReg & DS1390_MASK_FORMAT) >> 6);
+
   // Check if new format is equal to current
-  if (Format == ((HrsReg & DS1390_MASK_FORMAT) >> 6))
+  if (Format == _Format)
     return false;
 
   // Check if new format is invalid
   else if ((Format != DS1390_FORMAT_24H) && (Format != DS1390_FORMAT_12H))
     return false;
 
+#if DS1390_TIME_FORMAT != DS1390_FORMAT_RUNTIME
+  // Format fixed at compile time - Only switching to it is allowed
+  else if (Format != DS1390_TIME_FORMAT)
+    return false;
+#endif
+
   // Prepare new value of Hours register
   if (Format == DS1390_FORMAT_24H)
     HrsReg &= ~DS1390_MASK_FORMAT;
@@ -398,6 +837,19 @@ bool DS1390::setTimeFormat (uint8_t Format)
   // Send new Hours register
   writeByte (DS1390_ADDR_WRITE_HRS, HrsReg);
 
+  // Update cached format
+  _Format = Format;
+
+  // Update format copy in the boot marker - Only if there is one and the copy differs. The
+  // control register is read at most once (shared with the trim cache)
+  getTrim ();
+
+  if (((_Sram & DS1390_SRAM_TAG_MASK) == DS1390_SRAM_TAG) && (((_Sram & DS1390_SRAM_FORMAT) >> 5) != Format))
+  {
+    _Sram = (_Sram & ~DS1390_SRAM_FORMAT) | (Format << 5);
+    writeByte (DS1390_ADDR_WRITE_CFG, _Sram);
+  }
+
   // Set validation bit
   setValidation ();
 
@@ -407,88 +859,463 @@ bool DS1390::setTimeFormat (uint8_t Format)
 
 /* ------------------------------------------------------------------------------------------- */
 
-// Name:        getCenturyBase
-// Description: Calculates century base (__00)
-// Arguments:   Century - RTC century bit
-// Returns:     Current century year
+// Name:        getCenturyBase
+// Description: Calculates century base (__00)
+// Arguments:   Century - RTC century bit
+// Returns:     Current century year
+
+uint16_t DS1390::getCenturyBase (bool Century) const
+{
+  return _YearBase + (Century ? 100u : 0u);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getDateTimeAll
+// Description: Gets all time related register values from DS1390 memory
+// Arguments:   DateTime - DS1390DateTime structure to store the data
+// Returns:     None
+
+void DS1390::getDateTimeAll(DS1390DateTime &DateTime)
+{
+  // Raw register values
+  uint8_t Registers[8];
+
+  // Read all date and time registers at once
+  readBurst (DS1390_ADDR_READ_HSEC, Registers, 8);
+
+#if DS1390_TIME_FORMAT == DS1390_FORMAT_RUNTIME
+  // Refresh cached format for free
+  _Format = ((Registers[DS1390_ADDR_READ_HRS] & DS1390_MASK_FORMAT) >> 6);
+#endif
+
+  // Convert to DateTime
+  decodeDateTime (Registers, DateTime);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getDateTimeSnapshot
+// Description: Gets all time related register values from DS1390 memory, guarding against a
+//              rollover between the Hundredths of Seconds register and the remaining ones.
+//              A burst that starts at .99 is repeated until two bursts agree or a burst starts
+//              away from the boundary (at most DS1390_SNAPSHOT_MAX_READS bursts)
+// Arguments:   DateTime - DS1390DateTime structure to store the data
+// Returns:     Number of bursts read from DS1390 (1 in the common case)
+
+uint8_t DS1390::getDateTimeSnapshot (DS1390DateTime &DateTime)
+{
+  // Raw register values - Current and previous burst
+  uint8_t Registers[8];
+  uint8_t Previous[8];
+
+  // Number of bursts read
+  uint8_t Reads = 1;
+
+  // First burst
+  readBurst (DS1390_ADDR_READ_HSEC, Registers, 8);
+
+  // Re-read while the burst started right before a rollover
+  while ((bcd2dec(Registers[DS1390_ADDR_READ_HSEC]) >= DS1390_SNAPSHOT_HSEC_GUARD)
+         && (Reads < DS1390_SNAPSHOT_MAX_READS))
+  {
+    // Keep last burst
+    memcpy (Previous, Registers, 8);
+
+    // Read again
+    readBurst (DS1390_ADDR_READ_HSEC, Registers, 8);
+    Reads++;
+
+    // Seconds to Year unchanged - Both bursts are consistent
+    if (memcmp (&Previous[DS1390_ADDR_READ_SEC], &Registers[DS1390_ADDR_READ_SEC], 7) == 0)
+      break;
+  }
+
+#if DS1390_TIME_FORMAT == DS1390_FORMAT_RUNTIME
+  // Refresh cached format for free
+  _Format = ((Registers[DS1390_ADDR_READ_HRS] & DS1390_MASK_FORMAT) >> 6);
+#endif
+
+  // Convert to DateTime
+  decodeDateTime (Registers, DateTime);
+
+  // Return number of bursts
+  return Reads;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        waitForSecondEdge
+// Description: Returns right after the Seconds register changes. Hundredths of Seconds are read
+//              once to predict the edge, the wait until shortly before it uses delay() (other
+//              tasks may run), then only the Seconds register is polled
+// Arguments:   Second - Optional pointer to store the new seconds value
+// Returns:     false if the edge was not seen within DS1390_EDGE_MAX_POLLS polls or true on
+//              completion
+
+bool DS1390::waitForSecondEdge (uint8_t *Second)
+{
+  // Hundredths of Seconds and Seconds
+  uint8_t Registers[2];
+  readBurst (DS1390_ADDR_READ_HSEC, Registers, 2);
+
+  // Time to the predicted edge
+  const uint16_t Remaining = (100 - bcd2dec(Registers[0])) * 10;
+
+  // Sleep until shortly before the edge
+  if (Remaining > DS1390_EDGE_GUARD_MS)
+    delay (Remaining - DS1390_EDGE_GUARD_MS);
+
+  // Poll Seconds register
+  for (uint8_t Counter = 0; Counter < DS1390_EDGE_MAX_POLLS; Counter++)
+  {
+    const uint8_t Value = readByte (DS1390_ADDR_READ_SEC);
+
+    // Edge found
+    if (Value != Registers[1])
+    {
+      if (Second != nullptr)
+        *Second = bcd2dec(Value);
+
+      return true;
+    }
+
+    delayMicroseconds (DS1390_EDGE_POLL_US);
+  }
+
+  // Edge not found
+  return false;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        decodeDateTime
+// Description: Converts a raw image of the date and time registers to a DS1390DateTime structure
+// Arguments:   Registers - 8 bytes in DS1390 BCD format, Hundredths of Seconds first
+//              DateTime - DS1390DateTime structure to store the data
+// Returns:     None
+
+void DS1390::decodeDateTime (const uint8_t *Registers, DS1390DateTime &DateTime) const
+{
+  // Hours register
+  const uint8_t Hour = Registers[DS1390_ADDR_READ_HRS];
+
+  // Convert hours - 24h format
+#if DS1390_TIME_FORMAT == DS1390_FORMAT_RUNTIME
+  if ((Hour & DS1390_MASK_FORMAT) == 0)
+#else
+  if (DS1390_TIME_FORMAT == DS1390_FORMAT_24H)
+#endif
+  {
+    DateTime.Hour = bcd2dec(Hour & 0x3F);
+    DateTime.AmPm = 0;
+  }
+
+  // Convert hours and AM/PM flag - 12h format
+  else
+  {
+    DateTime.Hour = bcd2dec(Hour & 0x1F);
+    DateTime.AmPm = ((Hour & DS1390_MASK_AMPM) >> 5);
+  }
+
+  // Convert remaining fields
+  DateTime.Hsecond = bcd2dec(Registers[DS1390_ADDR_READ_HSEC]);
+  DateTime.Second = bcd2dec(Registers[DS1390_ADDR_READ_SEC]);
+  DateTime.Minute = bcd2dec(Registers[DS1390_ADDR_READ_MIN]);
+  DateTime.Wday = bcd2dec(Registers[DS1390_ADDR_READ_WDAY]);
+  DateTime.Day = bcd2dec(Registers[DS1390_ADDR_READ_DAY]);
+  DateTime.Month = bcd2dec(Registers[DS1390_ADDR_READ_MON] & 0x1F); // Ignore Century bit
+  DateTime.Year = bcd2dec(Registers[DS1390_ADDR_READ_YRS])
+                  + getCenturyBase(Registers[DS1390_ADDR_READ_MON] & DS1390_MASK_CENTURY);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        weekDayFromDate
+// Description: Calculates week day from the given date
+// Arguments:   DateTime - DS1390DateTime structure with a valid date
+// Returns:     Week day (1 = Sunday)
+
+uint8_t DS1390::weekDayFromDate (const DS1390DateTime &DateTime) {
+  static const char offsets[] PROGMEM = "-bed=pen+mad.";
+  const uint16_t y = DateTime.Year - (DateTime.Month < 3);
+  return (y + y/4 - y/100 + y/400 + pgm_read_byte(&offsets[DateTime.Month]) + DateTime.Day) % 7 + 1;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        hourTo24h
+// Description: Gets the hours of a DS1390DateTime structure in 24h format
+// Arguments:   DateTime - DS1390DateTime structure in the current time format
+// Returns:     Hours (0 to 23)
+
+uint8_t DS1390::hourTo24h (const DS1390DateTime &DateTime)
+{
+  // 12h mode - 12AM = 0h and 1-11PM = 13-23h
+  if (DS1390_IS_12H (*this))
+    return (DateTime.Hour % 12) + ((DateTime.AmPm == DS1390_PM) ? 12 : 0);
+
+  // 24h mode
+  return DateTime.Hour;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        hourFrom24h
+// Description: Sets the hours and AM/PM flag of a DS1390DateTime structure in the current
+//              time format
+// Arguments:   Hour - Hours in 24h format (0 to 23)
+//              DateTime - DS1390DateTime structure to store the data
+// Returns:     None
+
+void DS1390::hourFrom24h (uint8_t Hour, DS1390DateTime &DateTime)
+{
+  // 24h mode
+  DateTime.Hour = Hour;
+  DateTime.AmPm = 0;
+
+  // 12h mode - 0h = 12AM and 13-23h = 1-11PM
+  if (DS1390_IS_12H (*this))
+  {
+    DateTime.AmPm = (Hour >= 12) ? DS1390_PM : DS1390_AM;
+    DateTime.Hour = (Hour % 12) ? (Hour % 12) : 12;
+  }
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        monthLength
+// Description: Gets the number of days of a month
+// Arguments:   Month - Month (1 to 12)
+//              Year - Year
+// Returns:     Number of days
+
+uint8_t DS1390::monthLength (uint8_t Month, uint16_t Year)
+{
+  // February - Leap year
+  if ((Month == 2) && LEAP_YEAR(Year - 1970))
+    return 29;
+
+  return pgm_read_byte(&_MonthDuration[Month - 1]);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        addSeconds
+// Description: Adds seconds to a DS1390DateTime structure, carrying into the other fields
+//              without going through an epoch timestamp. Hundredths of seconds are kept
+// Arguments:   DateTime - DS1390DateTime structure with a valid date in the current format
+//              Seconds - Seconds to be added (negative values subtract)
+// Returns:     None
+
+void DS1390::addSeconds (DS1390DateTime &DateTime, int32_t Seconds)
+{
+  // New value - Usually within the minute
+  int32_t Value = DateTime.Second + Seconds;
+
+  if ((Value >= 0) && (Value < 60))
+  {
+    DateTime.Second = Value;
+    return;
+  }
+
+  // Carry whole minutes (rounded down)
+  int32_t Carry = Value / 60;
+  Value %= 60;
+
+  if (Value < 0)
+  {
+    Value += 60;
+    Carry--;
+  }
+
+  DateTime.Second = Value;
+  addMinutes (DateTime, Carry);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        addMinutes
+// Description: Adds minutes to a DS1390DateTime structure, carrying into the other fields
+// Arguments:   DateTime - DS1390DateTime structure with a valid date in the current format
+//              Minutes - Minutes to be added (negative values subtract)
+// Returns:     None
 
-uint16_t DS1390::getCenturyBase (bool Century) const
+void DS1390::addMinutes (DS1390DateTime &DateTime, int32_t Minutes)
 {
-  return _YearBase + (Century ? 100u : 0u);
+  // New value - Usually within the hour
+  int32_t Value = DateTime.Minute + Minutes;
+
+  if ((Value >= 0) && (Value < 60))
+  {
+    DateTime.Minute = Value;
+    return;
+  }
+
+  // Carry whole hours (rounded down)
+  int32_t Carry = Value / 60;
+  Value %= 60;
+
+  if (Value < 0)
+  {
+    Value += 60;
+    Carry--;
+  }
+
+  DateTime.Minute = Value;
+  addHours (DateTime, Carry);
 }
 
 /* ------------------------------------------------------------------------------------------- */
 
-// Name:        getDateTimeAll
-// Description: Gets all time related register values from DS1390 memory
-// Arguments:   DateTime - DS1390DateTime structure to store the data
+// Name:        addHours
+// Description: Adds hours to a DS1390DateTime structure, carrying into the other fields
+// Arguments:   DateTime - DS1390DateTime structure with a valid date in the current format
+//              Hours - Hours to be added (negative values subtract)
 // Returns:     None
 
-void DS1390::getDateTimeAll(DS1390DateTime &DateTime)
+void DS1390::addHours (DS1390DateTime &DateTime, int32_t Hours)
 {
-  // Struck to store raw read data
-  DS1390DateTime Buffer;
+  // New value in 24h format
+  int32_t Value = hourTo24h (DateTime) + Hours;
 
-  // Configure SPI transaction
-  SPI.beginTransaction(SPISettings(DS1390_SPI_CLOCK, MSBFIRST, SPI_MODE1));
+  // Carry whole days (rounded down)
+  int32_t Carry = 0;
 
-  // Select device (active low)
-  digitalWrite (_PinCs, LOW);
+  if ((Value < 0) || (Value >= 24))
+  {
+    Carry = Value / 24;
+    Value %= 24;
 
-  // Send first address byte
-  SPI.transfer (DS1390_ADDR_READ_HSEC);
+    if (Value < 0)
+    {
+      Value += 24;
+      Carry--;
+    }
+  }
 
-  // Read data bytes sequentially (0xFF = dummy)
-  Buffer.Hsecond = SPI.transfer (0xFF);
-  Buffer.Second = SPI.transfer (0xFF);
-  Buffer.Minute = SPI.transfer (0xFF);
-  Buffer.Hour = SPI.transfer (0xFF);
-  Buffer.Wday = SPI.transfer (0xFF);
-  Buffer.Day = SPI.transfer (0xFF);
-  Buffer.Month = SPI.transfer (0xFF);
-  Buffer.Year = SPI.transfer (0xFF);
+  // Back to current format
+  hourFrom24h (Value, DateTime);
 
-  // Deselect device (active low)
-  digitalWrite (_PinCs, HIGH);
+  if (Carry != 0)
+    addDays (DateTime, Carry);
+}
+
+/* ------------------------------------------------------------------------------------------- */
 
-  // End SPI transaction
-  SPI.endTransaction();
+// Name:        addDays
+// Description: Adds days to a DS1390DateTime structure. Each loop step skips a whole year while
+//              a year or more is left, so a delta takes one step per year crossed plus at most
+//              thirteen month steps (about 150 over the whole 32-bit epoch range). Time fields
+//              are kept and the week day is advanced (calculated if it is 0)
+// Arguments:   DateTime - DS1390DateTime structure with a valid date
+//              Days - Days to be added (negative values subtract)
+// Returns:     None
 
-  // Convert hours - 24h format
-  if (((Buffer.Hour & DS1390_MASK_FORMAT) >> 5) ==  DS1390_FORMAT_24H)
+void DS1390::addDays (DS1390DateTime &DateTime, int32_t Days)
+{
+  // Advance week day - Within 1 to 7
+  if ((DateTime.Wday >= 1) && (DateTime.Wday <= 7))
+    DateTime.Wday = ((DateTime.Wday - 1 + (Days % 7) + 7) % 7) + 1;
+
+  // Forward
+  while (Days > 0)
   {
-    DateTime.Hour = bcd2dec(Buffer.Hour & 0x3F);
-    DateTime.AmPm = 0;
+    // Result within the month
+    const uint8_t Length = monthLength (DateTime.Month, DateTime.Year);
+
+    if ((DateTime.Day + Days) <= Length)
+    {
+      DateTime.Day += Days;
+      break;
+    }
+
+    // Whole year - Same date next year (Feb 29 has no match)
+    if ((Days >= 366) && !((DateTime.Month == 2) && (DateTime.Day == 29)))
+    {
+      Days -= 365 + ((DateTime.Month <= 2) ? LEAP_YEAR(DateTime.Year - 1970) : LEAP_YEAR(DateTime.Year + 1 - 1970));
+      DateTime.Year++;
+      continue;
+    }
+
+    // First day of next month
+    Days -= Length - DateTime.Day + 1;
+    DateTime.Day = 1;
+
+    if (++DateTime.Month > 12)
+    {
+      DateTime.Month = 1;
+      DateTime.Year++;
+    }
   }
 
-  // Convert hours and AM/PM flag - 12h format
-  else
+  // Backward
+  while (Days < 0)
   {
-    DateTime.Hour = bcd2dec(Buffer.Hour & 0x1F);
-    DateTime.AmPm = ((Buffer.Hour & DS1390_MASK_AMPM) >> 5);
+    // Result within the month
+    if ((DateTime.Day + Days) >= 1)
+    {
+      DateTime.Day += Days;
+      break;
+    }
+
+    // Whole year - Same date last year (Feb 29 has no match)
+    if ((Days <= -366) && !((DateTime.Month == 2) && (DateTime.Day == 29)))
+    {
+      Days += 365 + ((DateTime.Month <= 2) ? LEAP_YEAR(DateTime.Year - 1 - 1970) : LEAP_YEAR(DateTime.Year - 1970));
+      DateTime.Year--;
+      continue;
+    }
+
+    // Last day of previous month
+    Days += DateTime.Day;
+
+    if (--DateTime.Month < 1)
+    {
+      DateTime.Month = 12;
+      DateTime.Year--;
+    }
+
+    DateTime.Day = monthLength (DateTime.Month, DateTime.Year);
   }
 
-  // Convert remaining fields
-  DateTime.Hsecond = bcd2dec(Buffer.Hsecond);
-  DateTime.Second = bcd2dec(Buffer.Second);
-  DateTime.Minute = bcd2dec(Buffer.Minute);
-  DateTime.Wday = bcd2dec(Buffer.Wday);
-  DateTime.Day = bcd2dec(Buffer.Day);
-  DateTime.Month = bcd2dec(Buffer.Month & 0x1F); // Ignore Century bit
-  DateTime.Year = bcd2dec(Buffer.Year) + getCenturyBase(Buffer.Month & DS1390_MASK_CENTURY);
+  // Week day not set - Calculate it
+  if ((DateTime.Wday < 1) || (DateTime.Wday > 7))
+    DateTime.Wday = weekDayFromDate (DateTime);
 }
 
 /* ------------------------------------------------------------------------------------------- */
 
-// Name:        weekDayFromDate
-// Description: Calculates week day from the given date
+// Name:        addMonths
+// Description: Adds months to a DS1390DateTime structure. The day is limited to the length of
+//              the new month (e.g. Jan 31 + 1 month = Feb 28 or 29)
 // Arguments:   DateTime - DS1390DateTime structure with a valid date
-// Returns:     Week day (1 = Sunday)
+//              Months - Months to be added (negative values subtract)
+// Returns:     None
 
-uint8_t DS1390::weekDayFromDate (const DS1390DateTime &DateTime) {
-  static const char offsets[] PROGMEM = "-bed=pen+mad.";
-  const uint16_t y = DateTime.Year - DateTime.Month < 3;
-  return (y + y/4 - y/100 + y/400 + pgm_read_byte(&offsets[DateTime.Month]) + DateTime.Day) % 7 + 1;
+void DS1390::addMonths (DS1390DateTime &DateTime, int32_t Months)
+{
+  // New value - Usually within the year
+  int32_t Value = DateTime.Month + Months;
+
+  if ((Value < 1) || (Value > 12))
+  {
+    // Months since January of year 0
+    Value += (int32_t)DateTime.Year * 12 - 1;
+    DateTime.Year = Value / 12;
+    Value = (Value % 12) + 1;
+  }
+
+  DateTime.Month = Value;
+
+  // Limit day to month length
+  const uint8_t Length = monthLength (DateTime.Month, DateTime.Year);
+
+  if (DateTime.Day > Length)
+    DateTime.Day = Length;
+
+  // Update week day
+  DateTime.Wday = weekDayFromDate (DateTime);
 }
 
 /* ------------------------------------------------------------------------------------------- */
@@ -501,9 +1328,30 @@ uint8_t DS1390::weekDayFromDate (const DS1390DateTime &DateTime) {
 
 void DS1390::setDateTimeAll(const DS1390DateTime &DateTime)
 {
-  // Struck to store raw data to be written
-  DS1390DateTime Buffer;
+  // Raw register values
+  uint8_t Registers[8];
+
+  // Convert from DateTime
+  encodeDateTime (DateTime, Registers);
 
+  // Write all date and time registers at once
+  writeBurst (DS1390_ADDR_WRITE_HSEC, Registers, 8);
+
+  // Set validation bit
+  setValidation ();
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        encodeDateTime
+// Description: Converts a DS1390DateTime structure to a raw image of the date and time registers
+// Arguments:   DateTime - DS1390DateTime structure with the data
+//              Wday if set to 0 will be calculated automatically.
+//              Registers - 8 bytes to store the data in DS1390 BCD format
+// Returns:     None
+
+void DS1390::encodeDateTime (const DS1390DateTime &DateTime, uint8_t *Registers)
+{
   // Calculates week day if not set
   uint8_t Wday = DateTime.Wday;
   if (Wday == 0) {
@@ -511,54 +1359,120 @@ void DS1390::setDateTimeAll(const DS1390DateTime &DateTime)
   }
 
   // Prepares buffer - Constrain values within allowed limits
-  Buffer.Hsecond = dec2bcd(constrain(DateTime.Hsecond, 0, 99));
-  Buffer.Second = dec2bcd(constrain(DateTime.Second, 0, 59));
-  Buffer.Minute = dec2bcd(constrain(DateTime.Minute, 0, 59));
-  Buffer.Wday = dec2bcd(constrain(Wday, 1, 7));
-  Buffer.Day = dec2bcd(constrain(DateTime.Day, 1, 31));
-  Buffer.Year = dec2bcd(DateTime.Year % 100);
+  Registers[DS1390_ADDR_READ_HSEC] = dec2bcd(constrain(DateTime.Hsecond, 0, 99));
+  Registers[DS1390_ADDR_READ_SEC] = dec2bcd(constrain(DateTime.Second, 0, 59));
+  Registers[DS1390_ADDR_READ_MIN] = dec2bcd(constrain(DateTime.Minute, 0, 59));
+  Registers[DS1390_ADDR_READ_WDAY] = dec2bcd(constrain(Wday, 1, 7));
+  Registers[DS1390_ADDR_READ_DAY] = dec2bcd(constrain(DateTime.Day, 1, 31));
+  Registers[DS1390_ADDR_READ_YRS] = dec2bcd(DateTime.Year % 100);
 
   // 24h mode
-  if (getTimeFormat() == DS1390_FORMAT_24H)
-    Buffer.Hour = dec2bcd(constrain(DateTime.Hour, 0, 23));
+  if (!DS1390_IS_12H (*this))
+    Registers[DS1390_ADDR_READ_HRS] = dec2bcd(constrain(DateTime.Hour, 0, 23));
 
   // 12h mode - Store AmPm info in AmPm bit of Hour register and make sure format bit is 1
   else
-    Buffer.Hour = dec2bcd(constrain(DateTime.Hour, 1, 12)) | (DateTime.AmPm << 5) | DS1390_MASK_FORMAT;
+    Registers[DS1390_ADDR_READ_HRS] = dec2bcd(constrain(DateTime.Hour, 1, 12)) | (DateTime.AmPm << 5) | DS1390_MASK_FORMAT;
 
   // Store Century info in Century bit of Month register
   const uint8_t Century = DateTime.Year >= getCenturyBase(true);
-  Buffer.Month = dec2bcd(constrain(DateTime.Month, 1, 12)) | (Century << 7);
+  Registers[DS1390_ADDR_READ_MON] = dec2bcd(constrain(DateTime.Month, 1, 12)) | (Century << 7);
+}
 
-  // Configure SPI transaction
-  SPI.beginTransaction(SPISettings(DS1390_SPI_CLOCK, MSBFIRST, SPI_MODE1));
+/* ------------------------------------------------------------------------------------------- */
 
-  // Select device (active low)
-  digitalWrite (_PinCs, LOW);
+#if DS1390_ENABLE_EPOCH
+
+// Name:        setDateTimePrecise
+// Description: Sets all time related register values in DS1390 memory from a reference time
+//              with sub-second resolution. The time elapsed since the reference was captured
+//              and the duration of the SPI burst are compensated, and the write is delayed so
+//              it completes on a hundredths of second boundary
+// Arguments:   Epoch - Epoch timestamp of the reference
+//              Milliseconds - Milliseconds of the reference (0 to 999)
+//              CaptureMicros - micros() value when the reference was captured
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of Epoch
+// Returns:     false if the write started late (less than DS1390_PRECISE_MARGIN_US was not
+//              enough for the conversion) or true otherwise
+
+bool DS1390::setDateTimePrecise (uint32_t Epoch, uint16_t Milliseconds, uint32_t CaptureMicros, DS1390Timezone Timezone)
+{
+  // Timed write
+  const bool OnTime = writeDateTimePrecise (Epoch, Milliseconds, CaptureMicros, Timezone);
 
-  // Send first address byte
-  SPI.transfer (DS1390_ADDR_WRITE_HSEC);
-
-  // Write data bytes sequentially (0xFF = dummy)
-  SPI.transfer (Buffer.Hsecond);
-  SPI.transfer (Buffer.Second);
-  SPI.transfer (Buffer.Minute);
-  SPI.transfer (Buffer.Hour);
-  SPI.transfer (Buffer.Wday);
-  SPI.transfer (Buffer.Day);
-  SPI.transfer (Buffer.Month);
-  SPI.transfer (Buffer.Year);
+  // New trim reference
+  setTrimAnchor (Epoch);
 
-  // Deselect device (active low)
-  digitalWrite (_PinCs, HIGH);
+  // Return timing result
+  return OnTime;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        writeDateTimePrecise
+// Description: Timed write of setDateTimePrecise - The trim anchor is not changed, so the
+//              written time may also be a shift of the current one (DS1390Slew)
+// Arguments:   Epoch - Epoch timestamp of the reference
+//              Milliseconds - Milliseconds of the reference (0 to 999)
+//              CaptureMicros - micros() value when the reference was captured
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of Epoch
+// Returns:     false if the write started late or true otherwise
 
-  // End SPI transaction
-  SPI.endTransaction();
+bool DS1390::writeDateTimePrecise (uint32_t Epoch, uint16_t Milliseconds, uint32_t CaptureMicros, DS1390Timezone Timezone)
+{
+  // Raw register values
+  uint8_t Registers[8];
+
+#if DS1390_TIME_FORMAT == DS1390_FORMAT_RUNTIME
+  // Make sure format is cached - No bus access between the timed steps below
+  getTimeFormat ();
+#endif
+
+  // Measure duration of an 8 byte burst - Same length as the write
+  uint32_t BurstStart = micros ();
+  readBurst (DS1390_ADDR_READ_HSEC, Registers, 8);
+  const uint32_t BurstMicros = micros () - BurstStart;
+
+  // Reference time when the margin is over - Seconds and microseconds
+  const uint32_t Start = micros ();
+  uint32_t Fraction = (uint32_t)Milliseconds * 1000 + (Start - CaptureMicros) + DS1390_PRECISE_MARGIN_US;
+  uint32_t Seconds = Epoch + Fraction / 1000000;
+  Fraction %= 1000000;
+
+  // Round up to the next hundredth - The write must complete at that time
+  uint8_t Hundredths = (Fraction + 9999) / 10000;
+  const uint32_t Wait = (uint32_t)Hundredths * 10000 - Fraction;
+
+  if (Hundredths == 100)
+  {
+    Hundredths = 0;
+    Seconds++;
+  }
+
+  // Convert target time
+  DS1390DateTime DateTime;
+  epochToDateTime (Seconds, DateTime, Timezone);
+  DateTime.Hsecond = Hundredths;
+  encodeDateTime (DateTime, Registers);
+
+  // Wait until the write has to start
+  const uint32_t WriteStart = Start + DS1390_PRECISE_MARGIN_US + Wait - BurstMicros;
+  const bool OnTime = ((int32_t)(micros () - WriteStart) <= 0);
+
+  while ((int32_t)(micros () - WriteStart) < 0);
+
+  // Write all date and time registers at once
+  writeBurst (DS1390_ADDR_WRITE_HSEC, Registers, 8);
 
   // Set validation bit
   setValidation ();
+
+  // Return timing result
+  return OnTime;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeHSeconds
@@ -574,6 +1488,8 @@ uint8_t DS1390::getDateTimeHSeconds ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeHSeconds
 // Description: Sets hundredths of seconds in DS1390 memory
 // Arguments:   Hundredths of seconds (constrained between 0 and 99)
@@ -588,6 +1504,8 @@ void DS1390::setDateTimeHSeconds (uint8_t Value)
   setValidation ();
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeSeconds
@@ -603,6 +1521,8 @@ uint8_t DS1390::getDateTimeSeconds ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeSeconds
 // Description: Sets seconds in DS1390 memory
 // Arguments:   Seconds (constrained between 0 and 59)
@@ -624,6 +1544,8 @@ bool DS1390::setDateTimeSeconds (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeMinutes
@@ -639,6 +1561,8 @@ uint8_t DS1390::getDateTimeMinutes ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeMinutes
 // Description: Sets minutes in DS1390 memory
 // Arguments:   Minutes (constrained between 0 and 59)
@@ -660,6 +1584,8 @@ bool DS1390::setDateTimeMinutes (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeHours
@@ -686,6 +1612,8 @@ uint8_t DS1390::getDateTimeHours ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeHours
 // Description: Sets hours in DS1390 memory
 // Arguments:   Hours (constrained between 0 and 23 in 24h format or 1 and 12 in 12h format)
@@ -698,7 +1626,7 @@ bool DS1390::setDateTimeHours (uint8_t Value)
     return false;
 
   // 24h mode
-  if (getTimeFormat() == DS1390_FORMAT_24H)
+  if (!DS1390_IS_12H (*this))
     Value = dec2bcd(constrain(Value, 0, 23));
 
   // 12h mode - Store AmPm info in AmPm bit of Hour register and make sure format bit is 1
@@ -718,6 +1646,8 @@ bool DS1390::setDateTimeHours (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeWday
@@ -733,6 +1663,8 @@ uint8_t DS1390::getDateTimeWday ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeWday
 // Description: Sets day of the week in DS1390 memory
 // Arguments:   Day of the week (constrained between 1 and 7)
@@ -754,6 +1686,8 @@ bool DS1390::setDateTimeWday (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeDay
@@ -769,6 +1703,8 @@ uint8_t DS1390::getDateTimeDay ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeDay
 // Description: Sets day in DS1390 memory
 // Arguments:   Day (constrained between 1 and 31)
@@ -790,6 +1726,8 @@ bool DS1390::setDateTimeDay (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeMonth
@@ -805,6 +1743,8 @@ uint8_t DS1390::getDateTimeMonth ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeMonth
 // Description: Sets month in DS1390 memory
 // Arguments:   Month (constrained between 1 and 12)
@@ -832,6 +1772,8 @@ bool DS1390::setDateTimeMonth (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeYear
@@ -848,6 +1790,8 @@ uint16_t DS1390::getDateTimeYear ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeYear
 // Description: Sets year in DS1390 memory
 // Arguments:   Year
@@ -870,8 +1814,12 @@ bool DS1390::setDateTimeYear (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_12H
+
 // Name:        getDateTimeAmPm
 // Description: Gets AM/PM flag from DS1390 memory
 // Arguments:   None
@@ -880,15 +1828,19 @@ bool DS1390::setDateTimeYear (uint8_t Value)
 uint8_t DS1390::getDateTimeAmPm ()
 {
   // 24h mode
-  if (getTimeFormat() == DS1390_FORMAT_24H)
+  if (!DS1390_IS_12H (*this))
     return 0;
 
   // 12h mode
   return (readByte(DS1390_ADDR_READ_HRS) & DS1390_MASK_AMPM) >> 5;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS && DS1390_ENABLE_12H
+
 // Name:        setDateTimeAmPm
 // Description: Sets AM/PM flag in DS1390 memory
 // Arguments:   DS1390_AM (logic 0) or DS1390_PM (logic 1)
@@ -897,7 +1849,7 @@ uint8_t DS1390::getDateTimeAmPm ()
 bool DS1390::setDateTimeAmPm (uint8_t Value)
 {
   // Check if device is in 24h mode
-  if (getTimeFormat() == DS1390_FORMAT_24H)
+  if (!DS1390_IS_12H (*this))
     return false;
 
   // Check if new value is equal to current
@@ -921,6 +1873,8 @@ bool DS1390::setDateTimeAmPm (uint8_t Value)
   return true;
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        getDateTimeCentury
@@ -936,6 +1890,8 @@ uint8_t DS1390::getDateTimeCentury ()
 
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_SETTERS
+
 // Name:        setDateTimeCentury
 // Description: Sets century flag in DS1390 memory
 // Arguments:   Shifted century flag (0 or 1)
@@ -947,8 +1903,12 @@ void DS1390::setDateTimeCentury (bool Value)
   writeByte (DS1390_ADDR_WRITE_MON, (dec2bcd(getDateTimeMonth()) | ((uint8_t)Value << 7)));
 }
 
+#endif
+
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_TRICKLE
+
 // Name:        getTrickleChargerMode
 // Description: Gets the current trickle charger settings
 // Arguments:   none
@@ -1001,37 +1961,343 @@ bool DS1390::setTrickleChargerMode (uint8_t Mode)
   return true;
 }
 
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getSquareWave
+// Description: Gets the square wave output setting of the control register (DS1391 only)
+// Arguments:   none
+// Returns:     DS1390_SQW_1HZ      - 1 Hz
+//              DS1390_SQW_4KHZ     - 4.096 kHz
+//              DS1390_SQW_8KHZ     - 8.192 kHz
+//              DS1390_SQW_32KHZ    - 32.768 kHz
+//              DS1390_SQW_DISABLE  - Disabled
+
+uint8_t DS1390::getSquareWave ()
+{
+  // Control register value
+  const uint8_t Control = readByte (DS1390_ADDR_READ_CFG);
+
+  // SQW/INT pin used for interrupts
+  if (Control & DS1390_MASK_INTCN)
+    return DS1390_SQW_DISABLE;
+
+  // Return rate bits
+  return (Control & DS1390_MASK_RS);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        setSquareWave
+// Description: Sets the square wave output of the SQW/INT pin (DS1391 only - In the DS1390, the
+//              control register is used as SRAM and holds the software trim)
+// Arguments:   DS1390_SQW_1HZ      - 1 Hz
+//              DS1390_SQW_4KHZ     - 4.096 kHz
+//              DS1390_SQW_8KHZ     - 8.192 kHz
+//              DS1390_SQW_32KHZ    - 32.768 kHz
+//              DS1390_SQW_DISABLE  - Disabled
+// Returns:     false if new rate is equal to current or invalid or true on completion
+
+bool DS1390::setSquareWave (uint8_t Rate)
+{
+  // Check if value is valid
+  if ((Rate != DS1390_SQW_1HZ) && (Rate != DS1390_SQW_4KHZ) && (Rate != DS1390_SQW_8KHZ)
+      && (Rate != DS1390_SQW_32KHZ) && (Rate != DS1390_SQW_DISABLE))
+    return false;
+
+  // Current value stored on control register
+  const uint8_t Control = readByte (DS1390_ADDR_READ_CFG);
+
+  // Replace rate and interrupt control bits - Keep oscillator enabled
+  const uint8_t NewControl = (Control & ~(DS1390_MASK_EOSC | DS1390_MASK_RS | DS1390_MASK_INTCN)) | Rate;
+
+  // Check if new value is equal to current
+  if (NewControl == Control)
+    return false;
+
+  // Send new control register
+  writeByte (DS1390_ADDR_WRITE_CFG, NewControl);
+
+  // Cached control register image is stale
+  _Trim = DS1390_TRIM_UNKNOWN;
+
+  // Success
+  return true;
+}
+
 /* ------------------------------------------------------------------------------------------- */
 
+#if DS1390_ENABLE_EPOCH
+
 // Name:        getDateTimeEpoch
-// Description: Gets all time related register values from DS1390 memory in Epoch format
-// Arguments:   Timezone - Timezone info (-12 to +12, 0 = GMT) to calculate Epoch
+// Description: Gets all time related register values from DS1390 memory in Epoch format. If a
+//              software trim and a reference (see setTrimAnchor) are set, the drift accumulated
+//              since the reference is removed. Both are kept in the DS1390 (control and alarm
+//              registers, see DS1390_ENABLE_TRIM_ANCHOR), so the correction continues after an
+//              MCU reset
+// Arguments:   Timezone - Offset from UTC (hours or DS1390Timezone) to calculate Epoch
+//              Milliseconds - Optional pointer to store the milliseconds (0 to 999)
 // Returns:     Epoch timestamp
 
-uint32_t DS1390::getDateTimeEpoch (int Timezone)
+uint32_t DS1390::getDateTimeEpoch (DS1390Timezone Timezone, uint16_t *Milliseconds)
 {
+  // Date and time buffer - Local, so concurrent calls do not share it
+  DS1390DateTime DateTime;
+
   // Get date and time from DS1390 memory
-  getDateTimeAll(_DateTimeBuffer);
-  
-  // Convert to Epoch format and return result
-  return dateTimeToEpoch (_DateTimeBuffer, Timezone);
+  getDateTimeAll(DateTime);
+
+  // Convert to trimmed Epoch format
+  return dateTimeToTrimmedEpoch (DateTime, Timezone, Milliseconds);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        dateTimeToTrimmedEpoch
+// Description: Converts DS1390DateTime structure read from the RTC to Epoch timestamp, removing
+//              the drift accumulated since the trim anchor like getDateTimeEpoch. Services that
+//              read the RTC themselves use it, so their time matches getDateTimeEpoch
+// Arguments:   DateTime - DS1390DateTime structure with the data (Hsecond is used)
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of DateTime
+//              Milliseconds - Optional pointer to store the milliseconds (0 to 999)
+// Returns:     Epoch timestamp referred to Timezone
+
+uint32_t DS1390::dateTimeToTrimmedEpoch (const DS1390DateTime &DateTime, DS1390Timezone Timezone, uint16_t *Milliseconds)
+{
+  // Convert to Epoch format
+  uint32_t Epoch = dateTimeToEpoch (DateTime, Timezone);
+  uint16_t Millis = DateTime.Hsecond * 10;
+
+  // Remove drift - The anchor is only read if a trim is set
+  const int8_t Trim = getTrim ();
+
+  if (Trim != 0)
+    Epoch = trimEpoch (Epoch, Millis, Trim, getTrimAnchor ());
+
+  // Milliseconds
+  if (Milliseconds != nullptr)
+    *Milliseconds = Millis;
+
+  // Return result
+  return Epoch;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        trimEpoch
+// Description: Removes the drift accumulated since the trim anchor from a raw RTC time. No
+//              DS1390 access, so it can be used with a trim and anchor read earlier (e.g. by
+//              services that count RTC time without reading it)
+// Arguments:   Epoch - Raw RTC time
+//              Milliseconds - Milliseconds of the raw RTC time (0 to 999), updated
+//              Trim - Software trim in ppm (see getTrim)
+//              Anchor - Trim anchor (see getTrimAnchor) - 0 if not known
+// Returns:     Trimmed epoch timestamp
+
+uint32_t DS1390::trimEpoch (uint32_t Epoch, uint16_t &Milliseconds, int8_t Trim, uint32_t Anchor)
+{
+  // No trim or no reference - Nothing to remove
+  if ((Trim == 0) || (Anchor == 0))
+    return Epoch;
+
+  // Drift accumulated since the reference - Trim is in ppm, so seconds / 1000 * ppm gives the
+  // correction in milliseconds
+  const int32_t Correction = ((int32_t)(Epoch - Anchor) / 1000) * Trim;
+  int16_t Millis = Milliseconds;
+
+  Epoch -= Correction / 1000;
+  Millis -= Correction % 1000;
+
+  // Carry milliseconds
+  if (Millis < 0)
+  {
+    Millis += 1000;
+    Epoch--;
+  }
+
+  else if (Millis >= 1000)
+  {
+    Millis -= 1000;
+    Epoch++;
+  }
+
+  // Return result
+  Milliseconds = Millis;
+  return Epoch;
 }
 
 /* ------------------------------------------------------------------------------------------- */
 
 // Name:        setDateTimeEpoch
-// Description: Sets all time related register values in DS1390 memory from an Epoch timestamp
+// Description: Sets all time related register values in DS1390 memory from an Epoch timestamp.
+//              The timestamp is used as the software trim reference
 // Arguments:   Epoch - Epoch timestamp
-//              Timezone - Timezone info (-12 to +12, 0 = GMT) of Epoch
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of Epoch
 // Returns:     None
 
-void DS1390::setDateTimeEpoch(uint32_t Epoch, int Timezone)
+void DS1390::setDateTimeEpoch(uint32_t Epoch, DS1390Timezone Timezone)
 {
+  // Date and time buffer - Local, so concurrent calls do not share it
+  DS1390DateTime DateTime;
+
   // Convert Epoch to DateTime
-  epochToDateTime (Epoch, _DateTimeBuffer, Timezone);
-  
+  epochToDateTime (Epoch, DateTime, Timezone);
+  DateTime.Hsecond = 0;
+
   // Write data to DS1390
-  setDateTimeAll(_DateTimeBuffer);
+  setDateTimeAll(DateTime);
+
+  // New trim reference
+  setTrimAnchor (Epoch);
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getTrim
+// Description: Gets the software trim stored in the control register (DS1390 only). DS1390
+//              memory is read only once, later calls return the cached value
+// Arguments:   None
+// Returns:     Trim in ppm (positive = RTC runs fast) - 0 if never set
+
+int8_t DS1390::getTrim ()
+{
+  // Read control register if not cached yet
+  if (_Trim == DS1390_TRIM_UNKNOWN)
+  {
+    _Sram = readByte (DS1390_ADDR_READ_CFG);
+
+    // Blank register - No trim stored
+    if ((_Sram & DS1390_SRAM_TAG_MASK) != DS1390_SRAM_TAG)
+      _Trim = 0;
+
+    // Sign extend trim bits
+    else
+      _Trim = (int8_t)((_Sram & DS1390_SRAM_TRIM_MASK) << 3) >> 3;
+  }
+
+  // Return cached trim
+  return _Trim;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        setTrim
+// Description: Stores the software trim in the control register (DS1390 only). It is kept by
+//              the backup supply, so it survives resets. getDateTimeEpoch applies it from the
+//              trim anchor (see setTrimAnchor). Setting a trim also stores an anchor already
+//              known in RAM in the alarm registers
+// Arguments:   Ppm - Trim in ppm, positive = RTC runs fast (constrained between DS1390_TRIM_MIN
+//              and DS1390_TRIM_MAX)
+// Returns:     false if new trim is equal to current or true on completion
+
+bool DS1390::setTrim (int8_t Ppm)
+{
+  // Constrain value within allowed limits
+  Ppm = constrain(Ppm, DS1390_TRIM_MIN, DS1390_TRIM_MAX);
+
+  // Check if new value is equal to current
+  const int8_t Previous = getTrim();
+
+  if (Ppm == Previous)
+    return false;
+
+  // Send tagged value to DS1390 - Includes format copy for the boot marker
+  _Sram = DS1390_SRAM_TAG | (getTimeFormat () << 5) | (Ppm & DS1390_SRAM_TRIM_MASK);
+  writeByte (DS1390_ADDR_WRITE_CFG, _Sram);
+
+  // Update cached trim
+  _Trim = Ppm;
+
+  // First trim - The anchor of the last set was kept in RAM only
+  if ((Previous == 0) && (_TrimAnchor != DS1390_ANCHOR_UNKNOWN) && (_TrimAnchor != 0))
+    writeTrimAnchor ();
+
+  // Success
+  return true;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getTrimAnchor
+// Description: Gets the time at which the RTC was last set from a reference. While a software
+//              trim is set, it is read from the alarm registers (DS1390 only) once, later calls
+//              return the cached value
+// Arguments:   None
+// Returns:     Epoch timestamp of the reference - 0 if not known
+
+uint32_t DS1390::getTrimAnchor ()
+{
+  // Not known yet - Stored in the alarm registers only while a trim is set
+  if (_TrimAnchor == DS1390_ANCHOR_UNKNOWN)
+  {
+    _TrimAnchor = 0;
+
+#if DS1390_ENABLE_TRIM_ANCHOR
+    if (getTrim () != 0)
+    {
+      uint8_t Registers[5];
+      readBurst (DS1390_ADDR_READ_AHSEC, Registers, 5);
+
+      // Rebuild epoch if the check byte matches - LSB first
+      if ((Registers[0] ^ Registers[1] ^ Registers[2] ^ Registers[3] ^ DS1390_ANCHOR_CHECK) == Registers[4])
+        _TrimAnchor = (uint32_t)Registers[0] | ((uint32_t)Registers[1] << 8)
+                      | ((uint32_t)Registers[2] << 16) | ((uint32_t)Registers[3] << 24);
+    }
+#endif
+  }
+
+  // Return cached anchor
+  return _TrimAnchor;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        setTrimAnchor
+// Description: Sets the time at which the RTC was last set from a reference. The software trim
+//              is applied to the time elapsed since then. setDateTimeEpoch and
+//              setDateTimePrecise call it. While a trim is set, it is also stored in the alarm
+//              registers (DS1390 only), so it survives MCU resets. Otherwise, and always with
+//              DS1390_ENABLE_TRIM_ANCHOR as 0, it is kept in RAM only and the alarm registers
+//              are not touched
+// Arguments:   Epoch - Epoch timestamp of the reference (same timezone as getDateTimeEpoch)
+// Returns:     None
+
+void DS1390::setTrimAnchor (uint32_t Epoch)
+{
+  // Update cached anchor
+  _TrimAnchor = Epoch;
+
+  // Store it only if a trim uses it
+  if (getTrim () != 0)
+    writeTrimAnchor ();
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        writeTrimAnchor
+// Description: Stores the cached trim anchor in the alarm registers (DS1390 only) - Any alarm
+//              programmed there is overwritten. Nothing is written with
+//              DS1390_ENABLE_TRIM_ANCHOR as 0
+// Arguments:   None
+// Returns:     None
+
+void DS1390::writeTrimAnchor ()
+{
+#if DS1390_ENABLE_TRIM_ANCHOR
+  // Epoch and check byte - LSB first
+  uint8_t Registers[5];
+  Registers[0] = _TrimAnchor;
+  Registers[1] = _TrimAnchor >> 8;
+  Registers[2] = _TrimAnchor >> 16;
+  Registers[3] = _TrimAnchor >> 24;
+  Registers[4] = Registers[0] ^ Registers[1] ^ Registers[2] ^ Registers[3] ^ DS1390_ANCHOR_CHECK;
+
+  // Send all bytes at once
+  writeBurst (DS1390_ADDR_WRITE_AHSEC, Registers, 5);
+#endif
 }
 
 /* ------------------------------------------------------------------------------------------- */
@@ -6,9 +6,15 @@
 // Date:    October 19, 2019
 //
 // Notes:   - A 200ms (min) delay is required after boot. It done inside the constructor
+//          - begin(true, true) skips that delay on warm starts using a boot marker stored in
+//            the control register (DS1390 only - It is the real control register in the DS1391)
 //          - Hundredths of Seconds register is ignored in Epoch related functions
 //          - Works with DS1391 aswell.
-//          - Alarm-related functions not implemented yet
+//          - Alarm-related functions not implemented yet - While a software trim is set, the
+//            alarm registers store its anchor (see DS1390_ENABLE_TRIM_ANCHOR)
+//          - Concurrency: all date and time buffers are local, so epoch conversions are
+//            reentrant once the time format is cached. Calls that access the SPI bus are not
+//            locked - Serialize them in the application or use a single DS1390Publisher
 //
 // Knwon bugs:  - In 12h format, the device do not change the AM/PM bit neither increments
 //              the day of the week and day counters. Everything works in 24h mode
@@ -33,6 +39,7 @@
 
 #include "Arduino.h"
 #include "SPI.h"
+#include "DS1390_SoftSpi.h"
 
 /* ------------------------------------------------------------------------------------------- */
 // Defines
@@ -42,9 +49,46 @@
 #define DS1390_CODE_NAME        "DS1390_SPI"
 #define DS1390_CODE_VERSION     "1.4"
 
-// DS1390 SPI clock speed
+// Feature selection - Define as 0 (e.g. -DDS1390_ENABLE_EPOCH=0) to leave the code out
+#ifndef DS1390_TIME_FORMAT           // Time format - DS1390_FORMAT_24H, _12H or _RUNTIME
+#if defined(DS1390_ENABLE_12H) && !DS1390_ENABLE_12H
+#define DS1390_TIME_FORMAT      DS1390_FORMAT_24H
+#else
+#define DS1390_TIME_FORMAT      DS1390_FORMAT_RUNTIME
+#endif
+#endif
+#ifndef DS1390_ENABLE_12H
+#define DS1390_ENABLE_12H       (DS1390_TIME_FORMAT != DS1390_FORMAT_24H) // 12h format support
+#endif
+#ifndef DS1390_ENABLE_SETTERS
+#define DS1390_ENABLE_SETTERS   1     // Single field setters (setDateTimeSeconds...)
+#endif
+#ifndef DS1390_ENABLE_EPOCH
+#define DS1390_ENABLE_EPOCH     1     // Epoch conversions and the services built on them
+#endif
+#ifndef DS1390_ENABLE_YEAR_TABLE
+#define DS1390_ENABLE_YEAR_TABLE 0    // PROGMEM year start table for epoch conversions
+#endif
+#ifndef DS1390_YEAR_TABLE_BASE
+#define DS1390_YEAR_TABLE_BASE  2000  // First year of the table (1970 or later)
+#endif
+#define DS1390_YEAR_TABLE_SIZE  128   // Years in the table (entries past 2106 are unused)
+#ifndef DS1390_ENABLE_TRICKLE
+#define DS1390_ENABLE_TRICKLE   1     // Trickle charger functions
+#endif
+#ifndef DS1390_ENABLE_TRIM_ANCHOR
+#define DS1390_ENABLE_TRIM_ANCHOR 1   // Trim anchor kept in the alarm registers while a trim is set
+#endif
+
+// DS1390 SPI clock speed - Default of each instance (see setClock and probeClock)
 #define DS1390_SPI_CLOCK        4000000
 
+// Clock probe - Doubles the clock from DS1390_PROBE_MIN_CLOCK, checking
+// DS1390_PROBE_PATTERNS write/readback cycles of the control register at each step
+#define DS1390_PROBE_MIN_CLOCK  1000000
+#define DS1390_PROBE_MAX_CLOCK  16000000
+#define DS1390_PROBE_PATTERNS   8
+
 // Trickle charger modes
 #define DS1390_TCH_DISABLE      0x00  // Disabled
 #define DS1390_TCH_250_NO_D     0xA5  // 250 Ohms without diode
@@ -57,6 +101,23 @@
 // Date formates
 #define DS1390_FORMAT_24H       0     // 24h format
 #define DS1390_FORMAT_12H       1     // 12h format
+#define DS1390_FORMAT_RUNTIME   2     // Read from the device (DS1390_TIME_FORMAT only)
+#define DS1390_FORMAT_UNKNOWN   0xFF  // Not read yet (internal cache state)
+
+// Fixed format - The device must be kept in DS1390_TIME_FORMAT. Format reads and the branches of
+// the other format are left out
+#if (DS1390_TIME_FORMAT == DS1390_FORMAT_24H) && DS1390_ENABLE_12H
+#error "DS1390_TIME_FORMAT is 24h only - DS1390_ENABLE_12H must be 0"
+#elif (DS1390_TIME_FORMAT != DS1390_FORMAT_24H) && !DS1390_ENABLE_12H
+#error "DS1390_ENABLE_12H is 0 - DS1390_TIME_FORMAT must be DS1390_FORMAT_24H"
+#endif
+
+// True if Rtc is in 12h format - Constant unless DS1390_TIME_FORMAT is DS1390_FORMAT_RUNTIME
+#if DS1390_TIME_FORMAT == DS1390_FORMAT_RUNTIME
+#define DS1390_IS_12H(Rtc)      ((Rtc).getTimeFormat () == DS1390_FORMAT_12H)
+#else
+#define DS1390_IS_12H(Rtc)      (DS1390_TIME_FORMAT == DS1390_FORMAT_12H)
+#endif
 
 #define DS1390_AM               0     // AM
 #define DS1390_PM               1     // PM
@@ -97,6 +158,47 @@
 #define DS1390_ADDR_WRITE_STS   0x8E  // Status
 #define DS1390_ADDR_WRITE_TCH   0x8F  // Trickle charger
 
+// Square wave output rates (DS1391 only) - RS2:RS1 bits, or INTCN set to disable
+#define DS1390_SQW_1HZ          0x00  // 1 Hz
+#define DS1390_SQW_4KHZ         0x08  // 4.096 kHz
+#define DS1390_SQW_8KHZ         0x10  // 8.192 kHz
+#define DS1390_SQW_32KHZ        0x18  // 32.768 kHz
+#define DS1390_SQW_DISABLE      0x04  // Square wave disabled (SQW/INT pin used for interrupts)
+
+// Control register as SRAM (DS1390 only) - Software trim and boot marker storage
+// Bits: [7:6] Tag (0b01, tells a written value from a blank 0x00/0xFF register) |
+//       [5] Copy of the 12h/24h format bit | [4:0] Trim in ppm (signed, positive = RTC runs fast)
+// Bit 7 is EOSC in the DS1391 control register, so the tag keeps it clear - A value written to
+// a DS1391 by mistake changes its square wave settings but never stops the oscillator
+#define DS1390_SRAM_TAG_MASK    0xC0  // Tag bits
+#define DS1390_SRAM_TAG         0x40  // Tag value
+#define DS1390_SRAM_FORMAT      0x20  // Format bit copy
+#define DS1390_SRAM_TRIM_MASK   0x1F  // Trim bits
+#define DS1390_TRIM_MIN         -16   // Minimum trim (ppm)
+#define DS1390_TRIM_MAX         15    // Maximum trim (ppm)
+#define DS1390_TRIM_UNKNOWN     -128  // Not read yet (internal cache state)
+
+// Alarm registers as storage (DS1390 only) - Software trim anchor, kept across MCU resets.
+// Written only while a trim is set, and never with DS1390_ENABLE_TRIM_ANCHOR as 0 (the anchor
+// is then kept in RAM only). Any alarm programmed in these registers is overwritten
+// Bytes: 0x08-0x0B Anchor epoch (LSB first) | 0x0C Check byte (XOR of the epoch bytes and
+//        DS1390_ANCHOR_CHECK, tells a written anchor from power-up contents)
+#define DS1390_ANCHOR_CHECK     0x5A  // Check byte seed
+#define DS1390_ANCHOR_UNKNOWN   0xFFFFFFFF // Not read yet (internal cache state)
+
+// Precise set - Time reserved for conversion before the timed write (us)
+#define DS1390_PRECISE_MARGIN_US    2000
+
+// Second edge detection - Sleep until this long before the predicted edge (ms), then poll
+// the Seconds register every DS1390_EDGE_POLL_US, at most DS1390_EDGE_MAX_POLLS times
+#define DS1390_EDGE_GUARD_MS        12
+#define DS1390_EDGE_POLL_US         1000
+#define DS1390_EDGE_MAX_POLLS       40
+
+// Snapshot read - Bursts starting at or above this hundredths value are checked for rollover
+#define DS1390_SNAPSHOT_HSEC_GUARD  99
+#define DS1390_SNAPSHOT_MAX_READS   3
+
 // DS1390 register bit masks
 #define DS1390_MASK_AMPM        0x20  // AM/PM bit
 #define DS1390_MASK_FORMAT      0x40  // 12h/24h format bit
@@ -104,6 +206,29 @@
 #define DS1390_MASK_OSF         0x80  // Oscillator stop flag bit
 #define DS1390_MASK_AMX         0x80  // Alarm  bit (x = 1-4)
 #define DS1390_MASK_DYDT        0x40  // Alarm day/date bit
+#define DS1390_MASK_EOSC        0x80  // Oscillator disable bit (DS1391 only)
+#define DS1390_MASK_RS          0x18  // Square wave rate bits (DS1391 only)
+#define DS1390_MASK_INTCN       0x04  // Interrupt control bit (DS1391 only)
+
+// Values stored in the control register must never set EOSC
+#if DS1390_SRAM_TAG & DS1390_MASK_EOSC
+#error "DS1390_SRAM_TAG must leave the DS1391 oscillator disable bit (EOSC) clear"
+#endif
+
+// Packed timestamp fields - Bit position and width (see DS1390Packed)
+#define DS1390_PACKED_SEC_POS   0     // Seconds (0-59)
+#define DS1390_PACKED_MIN_POS   6     // Minutes (0-59)
+#define DS1390_PACKED_HRS_POS   12    // Hours (0-23)
+#define DS1390_PACKED_DAY_POS   17    // Day (1-31)
+#define DS1390_PACKED_MON_POS   22    // Month (1-12)
+#define DS1390_PACKED_YRS_POS   26    // Year offset from YearBase (0-63)
+#define DS1390_PACKED_YRS_MAX   63    // Last year offset that fits
+
+// Timezone offset limits in minutes (see DS1390Timezone)
+#define DS1390_TZ_MIN_MINUTES   -720  // UTC-12:00
+#define DS1390_TZ_MAX_MINUTES   840   // UTC+14:00
+#define DS1390_TZ_SECONDS(M)    ((int32_t)(((M) < DS1390_TZ_MIN_MINUTES) ? DS1390_TZ_MIN_MINUTES : \
+                                 (((M) > DS1390_TZ_MAX_MINUTES) ? DS1390_TZ_MAX_MINUTES : (M))) * 60)
 
 // Leap year calulator
 #define LEAP_YEAR(Y)            (((1970+(Y))>0) && !((1970+(Y))%4) && (((1970+(Y))%100) || !((1970+(Y))%400)))
@@ -126,6 +251,29 @@ struct DS1390DateTime
   uint8_t AmPm = 0;     // AmPm flag - This field is set to 0 if 24h format is active
 };
 
+// Packed date and time - 32 bits, compares correctly as an integer
+// Bits: [31:26] Year - YearBase | [25:22] Month | [21:17] Day | [16:12] Hour (24h) |
+//       [11:6] Minute | [5:0] Second
+// Hundredths of seconds are not stored. If needed, keep them in an extra byte after the
+// packed value - (Packed, Hsecond) pairs still sort correctly
+typedef uint32_t DS1390Packed;
+
+// Timezone offset from UTC - Limited to DS1390_TZ_MIN/MAX_MINUTES and converted to seconds once.
+// An int is taken as whole hours, so hour based timezones are still accepted. Minutes take the
+// sign of Hours: DS1390Timezone (5, 30) is UTC+5:30 and DS1390Timezone (-3, 30) is UTC-3:30
+struct DS1390Timezone
+{
+  int32_t Seconds;      // Offset in seconds
+
+  // Constructor - Whole hours
+  constexpr DS1390Timezone (int Hours = 0)
+    : Seconds(DS1390_TZ_SECONDS((int32_t)Hours * 60)) {}
+
+  // Constructor - Hours and minutes
+  constexpr DS1390Timezone (int Hours, int Minutes)
+    : Seconds(DS1390_TZ_SECONDS((int32_t)Hours * 60 + ((Hours < 0) ? -Minutes : Minutes))) {}
+};
+
 /* ------------------------------------------------------------------------------------------- */
 // DS1390 class
 /* ------------------------------------------------------------------------------------------- */
@@ -134,13 +282,33 @@ class DS1390
 {
   public:
     // Constructor
-    constexpr DS1390 (uint16_t PinCs, uint16_t YearBase = 2000)
-      : _PinCs(PinCs),      // Save CS pin
-        _YearBase(YearBase) // Save starting year
+    DS1390 (uint16_t PinCs, uint16_t YearBase = 2000, uint32_t Clock = DS1390_SPI_CLOCK)
+      : _PinCs(PinCs),                    // Save CS pin
+        _YearBase(YearBase),              // Save starting year
+        _Clock(Clock),                    // Save SPI clock
+        _SpiSettings(Clock, MSBFIRST, SPI_MODE1), // Built once, used by every transaction
+        _SoftSpi(nullptr),                // Hardware SPI bus
+        _Validated(false),                // OSF state unknown until first access
+        _Format(DS1390_FORMAT_UNKNOWN),   // Format read on first use
+        _Trim(DS1390_TRIM_UNKNOWN),       // Trim read on first use
+        _TrimAnchor(DS1390_ANCHOR_UNKNOWN), // Anchor read on first use
+        _Sram(0)                          // Valid once the trim is read
     {}
 
+    // Constructor - Software SPI bus
+    DS1390 (uint16_t PinCs, DS1390SoftSpi &Bus, uint16_t YearBase = 2000)
+      : DS1390(PinCs, YearBase)
+    {
+      _SoftSpi = &Bus;
+    }
+
     // Initializer
-    void begin (bool Wait=true);
+    void begin (bool Wait=true, bool FastBoot=false);
+
+    // SPI clock related functions
+    uint32_t getClock () const;
+    void setClock (uint32_t Clock);
+    uint32_t probeClock (uint32_t MaxClock = DS1390_PROBE_MAX_CLOCK);
 
     // Time format related functions
     uint8_t getTimeFormat ();
@@ -149,62 +317,149 @@ class DS1390
     // Data validation related functions
     bool getValidation ();
     void setValidation ();
+    void revalidate ();
 
     // Date and time related functions
     void getDateTimeAll(DS1390DateTime &DateTime);
+    uint8_t getDateTimeSnapshot (DS1390DateTime &DateTime);
+    bool waitForSecondEdge (uint8_t *Second = nullptr);
     void setDateTimeAll(const DS1390DateTime &DateTime);
     uint8_t getDateTimeHSeconds ();
-    void setDateTimeHSeconds (uint8_t Value);
     uint8_t getDateTimeSeconds ();
-    bool setDateTimeSeconds (uint8_t Value);
     uint8_t getDateTimeMinutes ();
-    bool setDateTimeMinutes (uint8_t Value);
     uint8_t getDateTimeHours ();
-    bool setDateTimeHours (uint8_t Value);
     uint8_t getDateTimeWday ();
-    bool setDateTimeWday (uint8_t Value);
     uint8_t getDateTimeDay ();
-    bool setDateTimeDay (uint8_t Value);
     uint8_t getDateTimeMonth ();
-    bool setDateTimeMonth (uint8_t Value);
     uint16_t getDateTimeYear ();
-    bool setDateTimeYear (uint8_t Value);
+#if DS1390_ENABLE_12H
     uint8_t getDateTimeAmPm ();
+#endif
+#if DS1390_ENABLE_SETTERS
+    void setDateTimeHSeconds (uint8_t Value);
+    bool setDateTimeSeconds (uint8_t Value);
+    bool setDateTimeMinutes (uint8_t Value);
+    bool setDateTimeHours (uint8_t Value);
+    bool setDateTimeWday (uint8_t Value);
+    bool setDateTimeDay (uint8_t Value);
+    bool setDateTimeMonth (uint8_t Value);
+    bool setDateTimeYear (uint8_t Value);
+#if DS1390_ENABLE_12H
     bool setDateTimeAmPm (uint8_t Value);
-    uint32_t getDateTimeEpoch (int Timezone);
-    void setDateTimeEpoch(uint32_t Epoch, int Timezone);
+#endif
+#endif
+#if DS1390_ENABLE_EPOCH
+    uint32_t getDateTimeEpoch (DS1390Timezone Timezone, uint16_t *Milliseconds = nullptr);
+    void setDateTimeEpoch(uint32_t Epoch, DS1390Timezone Timezone);
+    bool setDateTimePrecise (uint32_t Epoch, uint16_t Milliseconds, uint32_t CaptureMicros, DS1390Timezone Timezone);
+#endif
 
+#if DS1390_ENABLE_TRICKLE
     // Trickle charger related functions
     uint8_t getTrickleChargerMode ();
     bool setTrickleChargerMode (uint8_t Mode);
+#endif
+
+    // Square wave output related functions (DS1391 only)
+    uint8_t getSquareWave ();
+    bool setSquareWave (uint8_t Rate);
 
+    // Software trim related functions
+    int8_t getTrim ();
+    bool setTrim (int8_t Ppm);
+    uint32_t getTrimAnchor ();
+    void setTrimAnchor (uint32_t Epoch);
+
+#if DS1390_ENABLE_EPOCH
     // Epoch timestamp related functions
-    uint32_t dateTimeToEpoch (DS1390DateTime &DateTime, int Timezone);
-    void epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, int Timezone);
+    uint32_t dateTimeToEpoch (const DS1390DateTime &DateTime, DS1390Timezone Timezone);
+    void epochToDateTime (uint32_t Epoch, DS1390DateTime &DateTime, DS1390Timezone Timezone);
+    uint32_t dateTimeToTrimmedEpoch (const DS1390DateTime &DateTime, DS1390Timezone Timezone, uint16_t *Milliseconds = nullptr);
+    static uint32_t trimEpoch (uint32_t Epoch, uint16_t &Milliseconds, int8_t Trim, uint32_t Anchor);
+#endif
+
+    // Calendar arithmetic related functions
+    void addSeconds (DS1390DateTime &DateTime, int32_t Seconds);
+    void addMinutes (DS1390DateTime &DateTime, int32_t Minutes);
+    void addHours (DS1390DateTime &DateTime, int32_t Hours);
+    void addDays (DS1390DateTime &DateTime, int32_t Days);
+    void addMonths (DS1390DateTime &DateTime, int32_t Months);
+
+    // Data conversion related functions
+    static uint8_t dec2bcd (uint8_t DecValue);
+    static uint8_t bcd2dec (uint8_t BCDValue);
+    static uint8_t weekDayFromDate (const DS1390DateTime &DateTime);
+
+    // Packed timestamp related functions
+    DS1390Packed packDateTime (const DS1390DateTime &DateTime);
+    void unpackDateTime (DS1390Packed Packed, DS1390DateTime &DateTime);
+    DS1390Packed packRegisters (const uint8_t *Registers) const;
+    void unpackRegisters (DS1390Packed Packed, uint8_t *Registers);
 
   private:
+    // Cached converter - Shares the time format conversion (hourFrom24h)
+    friend class DS1390Converter;
+
+    // Slewed correction - Shifts the time with writeDateTimePrecise (trim anchor kept)
+    friend class DS1390Slew;
+
     // CS pin mask
     const uint16_t _PinCs;
 
     // Starting year (+ century + year%100 = current year)
     const uint16_t _YearBase;
 
-    // DateTime buffer
-    DS1390DateTime _DateTimeBuffer;
+    // SPI clock and the transaction settings built from it
+    uint32_t _Clock;
+    SPISettings _SpiSettings;
+
+    // Software SPI bus - nullptr if the hardware SPI bus is used
+    DS1390SoftSpi *_SoftSpi;
+
+    // OSF bit known to be cleared - Skips status register access in setters
+    bool _Validated;
+
+    // Cached 12h/24h format bit - Avoids reading Hours register just to learn the format
+    uint8_t _Format;
+
+    // Cached software trim (ppm) and epoch of the last reference set (0 = none)
+    int8_t _Trim;
+    uint32_t _TrimAnchor;
+
+    // Cached control register (DS1390 SRAM) - Valid while _Trim is known
+    uint8_t _Sram;
 
     // Date calculation related functions
     uint16_t getCenturyBase (bool Century) const;
     uint8_t getDateTimeCentury ();
+#if DS1390_ENABLE_SETTERS
     void setDateTimeCentury (bool Value);
-    static uint8_t weekDayFromDate (const DS1390DateTime &DateTime);
+#endif
+    static uint8_t monthLength (uint8_t Month, uint16_t Year);
+    static uint32_t yearStart (uint16_t Year);
+    uint8_t hourTo24h (const DS1390DateTime &DateTime);
+    void hourFrom24h (uint8_t Hour, DS1390DateTime &DateTime);
+    void decodeDateTime (const uint8_t *Registers, DS1390DateTime &DateTime) const;
+    void encodeDateTime (const DS1390DateTime &DateTime, uint8_t *Registers);
+
+    // Bus access related functions
+    void beginTransfer ();
+    uint8_t transfer (uint8_t Data);
+    void endTransfer ();
 
     // Device memory related functions
     void writeByte (uint8_t Address, uint8_t Data);
     uint8_t readByte (uint8_t Address);
+    void readBurst (uint8_t Address, uint8_t *Data, uint8_t Length);
+    void writeBurst (uint8_t Address, const uint8_t *Data, uint8_t Length);
 
-    // Data conversion related functions
-    static uint8_t dec2bcd (uint8_t DecValue);
-    static uint8_t bcd2dec (uint8_t BCDValue);
+    // Software trim related functions
+    void writeTrimAnchor ();
+
+#if DS1390_ENABLE_EPOCH
+    // Timed write of setDateTimePrecise - Trim anchor unchanged
+    bool writeDateTimePrecise (uint32_t Epoch, uint16_t Milliseconds, uint32_t CaptureMicros, DS1390Timezone Timezone);
+#endif
 };
 
 #endif
@@ -0,0 +1,206 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_SampleFilter - Reference time sample filter for setting the DS1390 RTC
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SampleFilter.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Built on epoch conversions - Left out with DS1390_ENABLE_EPOCH
+#if DS1390_ENABLE_EPOCH
+
+// Name:        reset
+// Description: Clears all samples
+// Arguments:   none
+// Returns:     none
+
+void DS1390SampleFilter::reset ()
+{
+  _Count = 0;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        addSample
+// Description: Adds a reference time sample
+// Arguments:   Sample - Sample to be added
+// Returns:     false if the sample buffer is full or the sample is more than
+//              DS1390_FILTER_MAX_SPAN_S away from the first one or true on completion
+
+bool DS1390SampleFilter::addSample (const DS1390Sample &Sample)
+{
+  // Buffer full
+  if (_Count >= DS1390_FILTER_MAX_SAMPLES)
+    return false;
+
+  // Too far from the first sample - Offset would overflow
+  if (_Count != 0)
+  {
+    const int32_t Span = (int32_t)(Sample.Epoch - _Samples[0].Epoch);
+
+    if ((Span > DS1390_FILTER_MAX_SPAN_S) || (Span < -DS1390_FILTER_MAX_SPAN_S))
+      return false;
+  }
+
+  // Store sample
+  _Samples[_Count++] = Sample;
+
+  // Success
+  return true;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        collect
+// Description: Requests samples from a source
+// Arguments:   Source - Sample source callback
+//              Count - Number of requests
+//              IntervalMs - Delay between requests
+// Returns:     Number of samples stored
+
+uint8_t DS1390SampleFilter::collect (DS1390SampleSource Source, uint8_t Count, uint16_t IntervalMs)
+{
+  // New sample
+  DS1390Sample Sample;
+
+  for (uint8_t Counter = 0; Counter < Count; Counter++)
+  {
+    // Wait between requests
+    if ((Counter != 0) && (IntervalMs != 0))
+      delay (IntervalMs);
+
+    // Failed requests and rejected samples are skipped
+    if (Source (Sample))
+      addSample (Sample);
+
+    // Buffer full
+    if (_Count >= DS1390_FILTER_MAX_SAMPLES)
+      break;
+  }
+
+  // Return number of samples
+  return _Count;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getSamples
+// Description: Gets the number of samples stored
+// Arguments:   none
+// Returns:     Number of samples
+
+uint8_t DS1390SampleFilter::getSamples () const
+{
+  return _Count;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getOffset
+// Description: Calculates the reference time at capture minus the capture micros(), relative to
+//              the first sample. Samples from a consistent reference have the same offset
+// Arguments:   Index - Sample index
+// Returns:     Offset in microseconds
+
+int32_t DS1390SampleFilter::getOffset (uint8_t Index) const
+{
+  const DS1390Sample &First = _Samples[0];
+  const DS1390Sample &Sample = _Samples[Index];
+
+  return (int32_t)(Sample.Epoch - First.Epoch) * 1000000
+         + ((int32_t)Sample.Milliseconds - First.Milliseconds) * 1000
+         + ((int32_t)Sample.DelayMicros - (int32_t)First.DelayMicros) / 2
+         - (int32_t)(Sample.CaptureMicros - First.CaptureMicros);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getBest
+// Description: Rejects outliers and selects the sample with the smallest round-trip delay
+// Arguments:   Sample - Sample to store the result
+// Returns:     false if there are no samples or true on completion
+
+bool DS1390SampleFilter::getBest (DS1390Sample &Sample) const
+{
+  // No samples
+  if (_Count == 0)
+    return false;
+
+  // Offsets and sorted copy
+  int32_t Offsets[DS1390_FILTER_MAX_SAMPLES];
+  int32_t Sorted[DS1390_FILTER_MAX_SAMPLES];
+
+  for (uint8_t Counter = 0; Counter < _Count; Counter++)
+  {
+    Offsets[Counter] = getOffset (Counter);
+
+    // Insertion sort
+    uint8_t Position = Counter;
+    while ((Position > 0) && (Sorted[Position - 1] > Offsets[Counter]))
+    {
+      Sorted[Position] = Sorted[Position - 1];
+      Position--;
+    }
+    Sorted[Position] = Offsets[Counter];
+  }
+
+  // Median offset
+  const int32_t Median = Sorted[_Count / 2];
+
+  // Smallest delay among samples close to the median - The median sample always qualifies
+  uint8_t Best = _Count;
+
+  for (uint8_t Counter = 0; Counter < _Count; Counter++)
+  {
+    // Outlier
+    if ((Offsets[Counter] - Median > DS1390_FILTER_OUTLIER_US) || (Median - Offsets[Counter] > DS1390_FILTER_OUTLIER_US))
+      continue;
+
+    if ((Best == _Count) || (_Samples[Counter].DelayMicros < _Samples[Best].DelayMicros))
+      Best = Counter;
+  }
+
+  // Return best sample
+  Sample = _Samples[Best];
+  return true;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        apply
+// Description: Sets the RTC from the best sample using DS1390::setDateTimePrecise. Half the
+//              round-trip delay is added to the reference time
+// Arguments:   Clock - Initialized DS1390 object
+//              Timezone - Offset from UTC (hours or DS1390Timezone) of the samples
+// Returns:     false if there are no samples or the write started late (see
+//              setDateTimePrecise - The RTC is set anyway) or true on completion
+
+bool DS1390SampleFilter::apply (DS1390 &Clock, DS1390Timezone Timezone)
+{
+  // Best sample
+  DS1390Sample Sample;
+  if (!getBest (Sample))
+    return false;
+
+  // Reference at capture - Half the round-trip delay after the reference was sent
+  const uint32_t Fraction = (uint32_t)Sample.Milliseconds * 1000 + Sample.DelayMicros / 2;
+
+  // Set RTC - Return timing result
+  return Clock.setDateTimePrecise (Sample.Epoch + Fraction / 1000000, (Fraction % 1000000) / 1000,
+                                   Sample.CaptureMicros, Timezone);
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
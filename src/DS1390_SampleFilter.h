@@ -0,0 +1,87 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_SampleFilter - Reference time sample filter for setting the DS1390 RTC
+//
+// Notes:   - Samples come from any reference (NTP, GPS, host) through a DS1390SampleSource
+//            callback, so a synthetic source can be used for testing
+//          - Samples whose offset is far from the median are rejected, then the one with the
+//            smallest round-trip delay is used
+//          - The reference is assumed to be captured at half the round-trip delay
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_SampleFilter_h
+#define DS1390_SampleFilter_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SPI.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Maximum number of samples kept
+#define DS1390_FILTER_MAX_SAMPLES   8
+
+// Samples whose offset differs more than this from the median are rejected (us)
+#define DS1390_FILTER_OUTLIER_US    50000
+
+// Longest span between the first and any other sample (s) - Keeps offsets within 32 bits (us)
+// and capture times within the micros() period
+#define DS1390_FILTER_MAX_SPAN_S    1800
+
+/* ------------------------------------------------------------------------------------------- */
+// Structures
+/* ------------------------------------------------------------------------------------------- */
+
+// Reference time sample
+struct DS1390Sample
+{
+  uint32_t Epoch = 0;           // Reference epoch timestamp
+  uint16_t Milliseconds = 0;    // Reference milliseconds (0 to 999)
+  uint32_t DelayMicros = 0;     // Round-trip delay of the request
+  uint32_t CaptureMicros = 0;   // micros() when the reply was received
+};
+
+// Sample source - Fills a sample and returns false on failure
+typedef bool (*DS1390SampleSource) (DS1390Sample &Sample);
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390SampleFilter class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390SampleFilter
+{
+  public:
+    // Clears all samples
+    void reset ();
+
+    // Sample input
+    bool addSample (const DS1390Sample &Sample);
+    uint8_t collect (DS1390SampleSource Source, uint8_t Count, uint16_t IntervalMs = 0);
+    uint8_t getSamples () const;
+
+    // Filter result
+    bool getBest (DS1390Sample &Sample) const;
+
+    // Sets the RTC from the best sample
+    bool apply (DS1390 &Clock, DS1390Timezone Timezone);
+
+  private:
+    // Samples
+    DS1390Sample _Samples[DS1390_FILTER_MAX_SAMPLES];
+    uint8_t _Count = 0;
+
+    // Sample offset against the first sample (us)
+    int32_t getOffset (uint8_t Index) const;
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
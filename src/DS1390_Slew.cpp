@@ -0,0 +1,195 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Slew - Slewed time correction for the DS1390 RTC
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_Slew.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Built on epoch conversions - Left out with DS1390_ENABLE_EPOCH
+#if DS1390_ENABLE_EPOCH
+
+// Name:        adjust
+// Description: Starts slewing the served time by the given offset. Replaces any correction
+//              not served yet
+// Arguments:   OffsetMs - Reference time minus served time, in milliseconds (up to
+//              DS1390_SLEW_MAX_OFFSET_MS - Larger offsets must be stepped with setDateTimeEpoch)
+// Returns:     false if the offset is too large (pending correction unchanged) or true on
+//              completion
+
+bool DS1390Slew::adjust (int32_t OffsetMs)
+{
+  // Too large to slew - Caller steps the clock
+  if ((OffsetMs > DS1390_SLEW_MAX_OFFSET_MS) || (OffsetMs < -DS1390_SLEW_MAX_OFFSET_MS))
+    return false;
+
+  // Serve what is due so far with the old correction
+  update ();
+
+  // New correction
+  _Pending = OffsetMs * 1000;
+
+  // Success
+  return true;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getPending
+// Description: Gets the correction not served yet
+// Arguments:   none
+// Returns:     Remaining correction in milliseconds
+
+int32_t DS1390Slew::getPending () const
+{
+  return _Pending / 1000;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        update
+// Description: Moves part of the pending correction to the served time, limited by the slew
+//              rate, and writes whole hundredths of seconds to the RTC
+// Arguments:   none
+// Returns:     none
+
+void DS1390Slew::update ()
+{
+  // Elapsed time
+  const uint32_t Millis = millis ();
+  const uint32_t Elapsed = Millis - _LastMillis;
+  _LastMillis = Millis;
+
+  // Nothing to do
+  if (_Pending == 0)
+  {
+    _Remainder = 0;
+    return;
+  }
+
+  // Maximum step - ms * ppm / 1000 = us. Whole seconds and the rest are scaled apart to avoid
+  // overflow (idle periods limited to one hour), the fraction below 1 us is carried over
+  const uint32_t Limited = (Elapsed < 3600000UL) ? Elapsed : 3600000UL;
+  const uint32_t Fraction = (Limited % 1000) * _RatePpm + _Remainder;
+  const int32_t Step = (int32_t)((Limited / 1000) * _RatePpm + Fraction / 1000);
+  _Remainder = Fraction % 1000;
+
+  // Move step from pending to served
+  if (_Pending > 0)
+  {
+    const int32_t Value = (_Pending < Step) ? _Pending : Step;
+    _Pending -= Value;
+    _Served += Value;
+  }
+
+  else
+  {
+    const int32_t Value = (-_Pending < Step) ? -_Pending : Step;
+    _Pending += Value;
+    _Served -= Value;
+  }
+
+  // Write whole hundredths to the RTC
+  if ((_Served >= DS1390_SLEW_COMMIT_US) || (_Served <= -DS1390_SLEW_COMMIT_US))
+    commit (_Served / 10000);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        commit
+// Description: Shifts the RTC registers by the given number of hundredths of seconds and
+//              removes them from the served correction. The shift is applied to the time read
+//              right after a seconds edge and written with the timed write of
+//              setDateTimePrecise, so the time elapsed meanwhile is kept. Blocks up to about
+//              1 s, mostly in delay() (see waitForSecondEdge)
+// Arguments:   Hundredths - Shift (positive = forward)
+// Returns:     none
+
+void DS1390Slew::commit (int32_t Hundredths)
+{
+  // Wait for the next seconds edge - Retried on the next update if the oscillator is stopped
+  if (!_Clock.waitForSecondEdge ())
+    return;
+
+  // Reference captured at the edge
+  const uint32_t EdgeMicros = micros ();
+
+  // Current RTC time - Whole second at EdgeMicros
+  DS1390DateTime DateTime;
+  _Clock.getDateTimeSnapshot (DateTime);
+
+  // Shift in epoch and hundredths
+  uint32_t Epoch = _Clock.dateTimeToEpoch (DateTime, 0);
+  int32_t Total = Hundredths;
+
+  // Carry seconds
+  Epoch += Total / 100;
+  Total %= 100;
+
+  if (Total < 0)
+  {
+    Total += 100;
+    Epoch--;
+  }
+
+  // Write shifted time - Trim anchor is kept
+  _Clock.writeDateTimePrecise (Epoch, Total * 10, EdgeMicros, 0);
+
+  // Shift is now part of the RTC time
+  _Served -= Hundredths * 10000;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getEpoch
+// Description: Gets the RTC time plus the correction served so far
+// Arguments:   Timezone - Offset from UTC (hours or DS1390Timezone) to calculate Epoch
+//              Milliseconds - Optional pointer to store the milliseconds (0 to 999)
+// Returns:     Epoch timestamp
+
+uint32_t DS1390Slew::getEpoch (DS1390Timezone Timezone, uint16_t *Milliseconds)
+{
+  // Advance correction
+  update ();
+
+  // RTC time
+  uint16_t RtcMillis = 0;
+  uint32_t Epoch = _Clock.getDateTimeEpoch (Timezone, &RtcMillis);
+
+  // Add served correction - Less than one hundredth after update
+  int16_t Millis = RtcMillis + (_Served / 1000);
+
+  if (Millis < 0)
+  {
+    Millis += 1000;
+    Epoch--;
+  }
+
+  else if (Millis >= 1000)
+  {
+    Millis -= 1000;
+    Epoch++;
+  }
+
+  // Milliseconds
+  if (Milliseconds != nullptr)
+    *Milliseconds = Millis;
+
+  // Return result
+  return Epoch;
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
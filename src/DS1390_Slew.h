@@ -0,0 +1,94 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Slew - Slewed time correction for the DS1390 RTC
+//
+// Notes:   - adjust() does not step the RTC. The served time (getEpoch) converges to the
+//            reference at DS1390_SLEW_RATE_PPM at most
+//          - The correction already served is written to the RTC registers in whole
+//            hundredths of seconds, so the RTC follows the served time. Each write waits for a
+//            seconds edge, so update() and getEpoch() block up to about 1 s when one is due
+//            (once every 20 s at 500 ppm)
+//          - Large offsets take long to slew (1 s takes 2000 s at 500 ppm). Use
+//            setDateTimeEpoch for the initial set. adjust() rejects offsets above
+//            DS1390_SLEW_MAX_OFFSET_MS - Step the clock instead
+//          - The SlewConvergence example checks convergence and the rate bound against a
+//            synthetic reference clock
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_Slew_h
+#define DS1390_Slew_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SPI.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Default maximum slew rate (ppm) - Same limit used by NTP daemons
+#define DS1390_SLEW_RATE_PPM    500
+
+// Served correction written to the RTC once it reaches this value (us) - One hundredth
+#define DS1390_SLEW_COMMIT_US   10000
+
+// Largest offset accepted by adjust (ms) - Keeps the pending correction within 32 bits (us)
+#define DS1390_SLEW_MAX_OFFSET_MS   2000000L
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Slew class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390Slew
+{
+  public:
+    // Constructor
+    DS1390Slew (DS1390 &Clock, uint16_t RatePpm = DS1390_SLEW_RATE_PPM)
+      : _Clock(Clock),      // Save RTC object
+        _RatePpm(RatePpm)   // Save maximum slew rate
+    {}
+
+    // Starts a correction - Offset is reference time minus served time
+    bool adjust (int32_t OffsetMs);
+
+    // Correction not served yet
+    int32_t getPending () const;
+
+    // Advances the correction - Called by getEpoch, call it periodically otherwise
+    void update ();
+
+    // Served time
+    uint32_t getEpoch (DS1390Timezone Timezone, uint16_t *Milliseconds = nullptr);
+
+  private:
+    // RTC object
+    DS1390 &_Clock;
+
+    // Maximum slew rate (ppm)
+    const uint16_t _RatePpm;
+
+    // Correction not served yet (us)
+    int32_t _Pending = 0;
+
+    // Correction served but not written to the RTC (us)
+    int32_t _Served = 0;
+
+    // millis() at last update
+    uint32_t _LastMillis = 0;
+
+    // Step fraction not served yet (ms * ppm, below 1000) - Keeps frequent updates exact
+    uint16_t _Remainder = 0;
+
+    // Writes served correction to the RTC
+    void commit (int32_t Hundredths);
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -0,0 +1,105 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_SoftSpi - Bit-banged SPI bus (mode 1, MSB first) for the DS1390 RTC
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SoftSpi.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// One bit of a mode 1 transfer - Data is shifted out on the rising edge of the clock and
+// sampled after the falling edge
+#if DS1390_SOFTSPI_DIRECT
+#define DS1390_SOFTSPI_BIT(Bit)                           \
+  *_SckPort |= _SckMask;                                  \
+  if (Data & (1 << (Bit)))                                \
+    *_MosiPort |= _MosiMask;                              \
+  else                                                    \
+    *_MosiPort &= ~_MosiMask;                             \
+  *_SckPort &= ~_SckMask;                                 \
+  if (*_MisoPort & _MisoMask)                             \
+    Result |= (1 << (Bit));
+#else
+#define DS1390_SOFTSPI_BIT(Bit)                           \
+  digitalWrite (_PinSck, HIGH);                           \
+  digitalWrite (_PinMosi, (Data & (1 << (Bit))) ? HIGH : LOW); \
+  digitalWrite (_PinSck, LOW);                            \
+  if (digitalRead (_PinMiso))                             \
+    Result |= (1 << (Bit));
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        begin
+// Description: Configures bus pins - Clock idles low (mode 1)
+// Arguments:   None
+// Returns:     none
+
+void DS1390SoftSpi::begin ()
+{
+  // Clock idles low
+  digitalWrite (_PinSck, LOW);
+  pinMode (_PinSck, OUTPUT);
+  pinMode (_PinMosi, OUTPUT);
+  pinMode (_PinMiso, INPUT);
+
+#if DS1390_SOFTSPI_DIRECT
+  // Resolve port registers once
+  _SckPort = portOutputRegister (digitalPinToPort (_PinSck));
+  _MosiPort = portOutputRegister (digitalPinToPort (_PinMosi));
+  _MisoPort = portInputRegister (digitalPinToPort (_PinMiso));
+  _SckMask = digitalPinToBitMask (_PinSck);
+  _MosiMask = digitalPinToBitMask (_PinMosi);
+  _MisoMask = digitalPinToBitMask (_PinMiso);
+#endif
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        transfer
+// Description: Sends and receives a byte, MSB first - The bit loop is unrolled
+// Arguments:   Data - Byte to be sent
+// Returns:     Byte received
+
+uint8_t DS1390SoftSpi::transfer (uint8_t Data)
+{
+  // Received byte
+  uint8_t Result = 0;
+
+#if DS1390_SOFTSPI_DIRECT
+  // Port writes are read-modify-write - Keep interrupts from changing the same ports
+  const uint8_t Sreg = SREG;
+  cli ();
+#endif
+
+  DS1390_SOFTSPI_BIT(7)
+  DS1390_SOFTSPI_BIT(6)
+  DS1390_SOFTSPI_BIT(5)
+  DS1390_SOFTSPI_BIT(4)
+  DS1390_SOFTSPI_BIT(3)
+  DS1390_SOFTSPI_BIT(2)
+  DS1390_SOFTSPI_BIT(1)
+  DS1390_SOFTSPI_BIT(0)
+
+#if DS1390_SOFTSPI_DIRECT
+  // Restore interrupt state
+  SREG = Sreg;
+#endif
+
+  // Return received byte
+  return Result;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
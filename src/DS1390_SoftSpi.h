@@ -0,0 +1,76 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_SoftSpi - Bit-banged SPI bus (mode 1, MSB first) for the DS1390 RTC
+//
+// Notes:   - For boards where the DS1390 is not wired to the hardware SPI pins. Pass the bus
+//            to the DS1390 constructor - All DS1390 functions work the same way
+//          - On AVR, pins are driven through their port registers with interrupts disabled
+//            during each byte. Other architectures fall back to digitalWrite/digitalRead
+//          - The bit rate depends on the MCU only. DS1390::setClock has no effect on it
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_SoftSpi_h
+#define DS1390_SoftSpi_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Direct port access - Set to 0 with compiler flags (-D) to force digitalWrite/digitalRead
+#ifndef DS1390_SOFTSPI_DIRECT
+#if defined(__AVR__)
+#define DS1390_SOFTSPI_DIRECT   1
+#else
+#define DS1390_SOFTSPI_DIRECT   0
+#endif
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390SoftSpi class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390SoftSpi
+{
+  public:
+    // Constructor
+    DS1390SoftSpi (uint8_t PinSck, uint8_t PinMosi, uint8_t PinMiso)
+      : _PinSck(PinSck),      // Save clock pin
+        _PinMosi(PinMosi),    // Save data output pin
+        _PinMiso(PinMiso)     // Save data input pin
+    {}
+
+    // Initializer - Configures pins, clock idles low
+    void begin ();
+
+    // Full duplex byte transfer
+    uint8_t transfer (uint8_t Data);
+
+  private:
+    // Bus pins
+    const uint8_t _PinSck;
+    const uint8_t _PinMosi;
+    const uint8_t _PinMiso;
+
+#if DS1390_SOFTSPI_DIRECT
+    // Port registers and bit masks - Read in begin()
+    volatile uint8_t *_SckPort = nullptr;
+    volatile uint8_t *_MosiPort = nullptr;
+    volatile uint8_t *_MisoPort = nullptr;
+    uint8_t _SckMask = 0;
+    uint8_t _MosiMask = 0;
+    uint8_t _MisoMask = 0;
+#endif
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -0,0 +1,234 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Tick - Timekeeping from the DS1391 square wave output
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_Tick.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Functions definitions
+/* ------------------------------------------------------------------------------------------- */
+
+// Built on epoch conversions - Left out with DS1390_ENABLE_EPOCH
+#if DS1390_ENABLE_EPOCH
+
+// Instance served by the interrupt routine
+DS1390Tick *DS1390Tick::_Instance = nullptr;
+
+// Name:        handleEdge
+// Description: Interrupt routine - Counts a falling edge of the square wave
+// Arguments:   none
+// Returns:     none
+
+void DS1390_ISR_ATTR DS1390Tick::handleEdge ()
+{
+  DS1390Tick *Tick = _Instance;
+
+  if (Tick == nullptr)
+    return;
+
+  Tick->_EdgeMicros = micros ();
+
+  if (++Tick->_Ticks >= Tick->_Rate)
+  {
+    Tick->_Ticks = 0;
+    Tick->_Seconds++;
+  }
+
+  Tick->_Edges++;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        begin
+// Description: Enables the square wave output, attaches the interrupt and reads the RTC right
+//              after the first edge. The RTC hundredths at that moment give the phase of the
+//              edges within the second
+// Arguments:   Clock - Initialized DS1390 object (DS1391 device)
+//              Pin - MCU pin wired to SQW/INT (open drain - The internal pull-up is enabled)
+//              Rate - DS1390_SQW_1HZ, DS1390_SQW_4KHZ, DS1390_SQW_8KHZ or DS1390_SQW_32KHZ
+// Returns:     false if the rate is invalid or no edge was seen within DS1390_TICK_TIMEOUT_MS
+//              (e.g. SQW/INT not wired to Pin - The interrupt is detached), true otherwise
+
+bool DS1390Tick::begin (DS1390 &Clock, uint8_t Pin, uint8_t Rate)
+{
+  // Edges per second
+  switch (Rate)
+  {
+    case DS1390_SQW_1HZ:
+      _Rate = 1;
+      break;
+    case DS1390_SQW_4KHZ:
+      _Rate = 4096;
+      break;
+    case DS1390_SQW_8KHZ:
+      _Rate = 8192;
+      break;
+    case DS1390_SQW_32KHZ:
+      _Rate = 32768;
+      break;
+    default:
+      return false;
+  }
+
+  // Stop a previous run
+  end ();
+
+  // Reset counters
+  _Seconds = 0;
+  _Ticks = 0;
+  _Edges = 0;
+
+  // Enable square wave output
+  Clock.setSquareWave (Rate);
+
+  // Attach interrupt
+  _Pin = Pin;
+  _Instance = this;
+  pinMode (Pin, INPUT_PULLUP);
+  attachInterrupt (digitalPinToInterrupt (Pin), handleEdge, FALLING);
+
+  // Wait for the first edge - Lets other tasks (and the ESP watchdogs) run meanwhile
+  const uint32_t Start = millis ();
+
+  while (_Edges == 0)
+  {
+    // No edge - Detach the interrupt and give up
+    if ((millis () - Start) > DS1390_TICK_TIMEOUT_MS)
+    {
+      end ();
+      return false;
+    }
+
+    yield ();
+  }
+
+  // Counters at the anchor edge
+  uint32_t EdgeMicros = 0;
+  readCounters (_AnchorSeconds, _AnchorTicks, EdgeMicros);
+
+  // Read a consistent snapshot
+  DS1390DateTime DateTime;
+  Clock.getDateTimeSnapshot (DateTime);
+
+  // Save anchor - Raw RTC time, trimmed in getEpoch
+  _AnchorMillis = DateTime.Hsecond * 10;
+  _AnchorEpoch = Clock.dateTimeToEpoch (DateTime, 0);
+
+  // Software trim - Applied without SPI access
+  _Trim = Clock.getTrim ();
+  _TrimAnchor = (_Trim != 0) ? Clock.getTrimAnchor () : 0;
+
+  // Success
+  return true;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        end
+// Description: Detaches the interrupt - The square wave output is left enabled
+// Arguments:   none
+// Returns:     none
+
+void DS1390Tick::end ()
+{
+  if (_Instance != this)
+    return;
+
+  detachInterrupt (digitalPinToInterrupt (_Pin));
+  _Instance = nullptr;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        readCounters
+// Description: Copies the interrupt counters - Retried if an edge arrives during the copy
+// Arguments:   Seconds - Whole seconds counted
+//              Ticks - Edges counted within the current second
+//              EdgeMicros - micros() value of the last edge
+// Returns:     none
+
+void DS1390Tick::readCounters (uint32_t &Seconds, uint16_t &Ticks, uint32_t &EdgeMicros) const
+{
+  uint8_t Edges;
+
+  do
+  {
+    Edges = _Edges;
+    Seconds = _Seconds;
+    Ticks = _Ticks;
+    EdgeMicros = _EdgeMicros;
+  } while (Edges != _Edges);
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getEpoch
+// Description: Gets the anchor epoch advanced by the edges counted since then. The time since
+//              the last edge is added from micros(), limited to one square wave period. The
+//              software trim read in begin() is applied, like in getDateTimeEpoch
+// Arguments:   Milliseconds - Optional pointer to store the milliseconds (0 to 999)
+// Returns:     Epoch timestamp (GMT)
+
+uint32_t DS1390Tick::getEpoch (uint16_t *Milliseconds) const
+{
+  // Counters
+  uint32_t Seconds;
+  uint16_t Ticks;
+  uint32_t EdgeMicros;
+  readCounters (Seconds, Ticks, EdgeMicros);
+
+  // Time since the last edge - At most one period
+  uint32_t SinceEdge = micros () - EdgeMicros;
+  const uint32_t Period = 1000000UL / _Rate;
+
+  if (SinceEdge > Period)
+    SinceEdge = Period;
+
+  // Milliseconds since the anchor second - Edges within the second may be fewer than at the
+  // anchor, so this can be negative before normalization
+  int32_t Millis = (int32_t)_AnchorMillis + (((int32_t)Ticks - _AnchorTicks) * 1000) / _Rate
+                   + (int32_t)(SinceEdge / 1000);
+  uint32_t Epoch = _AnchorEpoch + (Seconds - _AnchorSeconds);
+
+  while (Millis < 0)
+  {
+    Millis += 1000;
+    Epoch--;
+  }
+
+  Epoch += Millis / 1000;
+
+  // Remove drift like getDateTimeEpoch - Edges follow the untrimmed RTC oscillator
+  uint16_t Trimmed = Millis % 1000;
+  Epoch = DS1390::trimEpoch (Epoch, Trimmed, _Trim, _TrimAnchor);
+
+  if (Milliseconds != nullptr)
+    *Milliseconds = Trimmed;
+
+  return Epoch;
+}
+
+/* ------------------------------------------------------------------------------------------- */
+
+// Name:        getRate
+// Description: Gets the number of square wave edges per second
+// Arguments:   none
+// Returns:     Edges per second
+
+uint16_t DS1390Tick::getRate () const
+{
+  return _Rate;
+}
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */
@@ -0,0 +1,99 @@
+/* ------------------------------------------------------------------------------------------- */
+// DS1390_Tick - Timekeeping from the DS1391 square wave output
+//
+// Notes:   - DS1391 only - The DS1390 has no SQW/INT pin
+//          - The RTC is read only once, in begin(). Later reads count square wave edges on an
+//            interrupt pin, so the time stays locked to the RTC oscillator without SPI access
+//          - One instance at a time (the interrupt routine uses a static instance pointer)
+//          - 1 Hz is the lightest rate for the MCU. Higher rates give finer ticks at the cost
+//            of one interrupt per period (32768 per second at DS1390_SQW_32KHZ)
+//
+// Released into the public domain
+/* ------------------------------------------------------------------------------------------- */
+
+#ifndef DS1390_Tick_h
+#define DS1390_Tick_h
+
+/* ------------------------------------------------------------------------------------------- */
+// Includes
+/* ------------------------------------------------------------------------------------------- */
+
+#include "Arduino.h"
+#include "DS1390_SPI.h"
+
+/* ------------------------------------------------------------------------------------------- */
+// Defines
+/* ------------------------------------------------------------------------------------------- */
+
+// Interrupt routines must be placed in RAM on ESP boards
+#if defined(ESP32) || defined(ESP8266)
+#define DS1390_ISR_ATTR         IRAM_ATTR
+#else
+#define DS1390_ISR_ATTR
+#endif
+
+// Time to wait for the first edge in begin() (ms)
+#ifndef DS1390_TICK_TIMEOUT_MS
+#define DS1390_TICK_TIMEOUT_MS  1500
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// DS1390Tick class
+/* ------------------------------------------------------------------------------------------- */
+
+class DS1390Tick
+{
+  public:
+    // Initializer - Enables the square wave and reads the RTC anchor
+    bool begin (DS1390 &Clock, uint8_t Pin, uint8_t Rate = DS1390_SQW_1HZ);
+
+    // Stops counting edges
+    void end ();
+
+    // Anchor epoch (GMT) advanced by the counted edges
+    uint32_t getEpoch (uint16_t *Milliseconds = nullptr) const;
+
+    // Edges per second
+    uint16_t getRate () const;
+
+  private:
+    // Interrupt pin
+    uint8_t _Pin = 0;
+
+    // Edges per second
+    uint16_t _Rate = 1;
+
+    // RTC time at the anchor edge - Epoch (GMT) and milliseconds
+    uint32_t _AnchorEpoch = 0;
+    uint16_t _AnchorMillis = 0;
+
+    // Software trim and its anchor, read in begin()
+    int8_t _Trim = 0;
+    uint32_t _TrimAnchor = 0;
+
+    // Counters at the anchor edge
+    uint32_t _AnchorSeconds = 0;
+    uint16_t _AnchorTicks = 0;
+
+    // Counters updated by the interrupt - Whole seconds, edges within the second, micros()
+    // of the last edge and a change counter (8 bits, so it is read atomically)
+    volatile uint32_t _Seconds = 0;
+    volatile uint16_t _Ticks = 0;
+    volatile uint32_t _EdgeMicros = 0;
+    volatile uint8_t _Edges = 0;
+
+    // Instance served by the interrupt routine
+    static DS1390Tick *_Instance;
+
+    // Interrupt routine
+    static void DS1390_ISR_ATTR handleEdge ();
+
+    // Consistent copy of the interrupt counters
+    void readCounters (uint32_t &Seconds, uint16_t &Ticks, uint32_t &EdgeMicros) const;
+};
+
+#endif
+
+/* ------------------------------------------------------------------------------------------- */
+// End of code
+/* ------------------------------------------------------------------------------------------- */